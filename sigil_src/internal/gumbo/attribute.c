@@ -39,8 +39,11 @@ GumboAttribute* gumbo_get_attribute(
 
 void gumbo_attribute_set_value(GumboAttribute *attr, const char *value)
 {
+  // the new value lives wherever the attribute itself does
+  GumboArena *previous_arena = gumbo_arena_swap(gumbo_arena_of(attr));
   gumbo_free((void *)attr->value);
   attr->value = gumbo_strdup(value);
+  gumbo_arena_swap(previous_arena);
   attr->original_value = kGumboEmptyString;
   attr->value_start = kGumboEmptySourcePosition;
   attr->value_end = kGumboEmptySourcePosition;
@@ -57,6 +60,9 @@ void gumbo_element_set_attribute(
 {
   GumboVector *attributes = &element->attributes;
   GumboAttribute *attr = gumbo_get_attribute(attributes, name);
+  // allocate any new attribute from the arena of the node holding element
+  GumboNode *node = (GumboNode *)((char *)element - offsetof(GumboNode, v));
+  GumboArena *previous_arena = gumbo_arena_swap(gumbo_arena_of(node));
 
   if (!attr) {
     attr = gumbo_malloc(sizeof(GumboAttribute));
@@ -72,6 +78,7 @@ void gumbo_element_set_attribute(
   }
 
   gumbo_attribute_set_value(attr, value);
+  gumbo_arena_swap(previous_arena);
 }
 
 void gumbo_element_remove_attribute_at(GumboElement *element, unsigned int pos) {
@@ -600,6 +600,16 @@ typedef struct GumboInternalOptions {
    */
   int max_errors;
 
+  /**
+   * Whether to take all of the memory for this parse from a private arena
+   * instead of the global allocator, so that concurrent parses do not
+   * contend on the heap and gumbo_destroy_output can release the whole
+   * tree at once.  Nodes and attributes added to the tree afterwards with
+   * the gumbo_edit routines work just as before.
+   * Default: false.
+   */
+  bool use_arena;
+
 } GumboOptions;
 
 /** Default options struct; use this with gumbo_parse_with_options. */
@@ -660,6 +670,12 @@ typedef struct GumboInternalOutput {
    */
   GumboOutputStatus status;
 
+  /**
+   * The arena that owns this output if it was parsed with
+   * GumboOptions::use_arena set, otherwise NULL.
+   */
+  struct GumboInternalArena* arena;
+
 } GumboOutput;
 
 /**
@@ -74,6 +74,8 @@ GumboOutput*  gumbo_new_output_init(void) {
   output->root = NULL;
   output->document = gumbo_new_document_node();
   gumbo_vector_init(0, &output->errors);
+  output->status = GUMBO_STATUS_OK;
+  output->arena = NULL;
   return output;
 }
 
@@ -143,7 +145,12 @@ void gumbo_append_node(GumboNode* parent, GumboNode* node) {
   }
   node->parent = parent;
   node->index_within_parent = children->length;
+  // keep the parent's tree in its own arena if it has one
+  GumboArena* arena = gumbo_arena_of(parent);
+  GumboArena* previous_arena = gumbo_arena_swap(arena);
+  gumbo_arena_adopt(arena, node);
   gumbo_vector_add((void*) node, children);
+  gumbo_arena_swap(previous_arena);
   assert(node->index_within_parent < children->length);
 }
 
@@ -170,7 +177,12 @@ void gumbo_insert_node(GumboNode* node, GumboNode* target_parent, int target_ind
     assert(index <= children->length);
     node->parent = parent;
     node->index_within_parent = index;
+    // keep the parent's tree in its own arena if it has one
+    GumboArena* arena = gumbo_arena_of(parent);
+    GumboArena* previous_arena = gumbo_arena_swap(arena);
+    gumbo_arena_adopt(arena, node);
     gumbo_vector_insert_at((void*) node, index, children);
+    gumbo_arena_swap(previous_arena);
     assert(node->index_within_parent < children->length);
     for (unsigned int i = index + 1; i < children->length; ++i) {
       GumboNode* sibling = children->data[i];
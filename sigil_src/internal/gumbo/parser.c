@@ -60,6 +60,7 @@ const GumboOptions kGumboDefaultOptions = {
   false,                    /* stop_on_first_error */
   400,                      /* max_tree_depth */
   50,                       /* max_errors */
+  false,                    /* use_arena */
 };
 
 static const GumboStringPiece kDoctypeHtml = GUMBO_STRING("html");
@@ -352,6 +353,7 @@ static void output_init(GumboParser* parser) {
   output->root = NULL;
   output->document = new_document_node();
   output->status = GUMBO_STATUS_OK;
+  output->arena = NULL;
   parser->_output = output;
   gumbo_init_errors(parser);
 }
@@ -4545,10 +4547,14 @@ GumboOutput* gumbo_parse_fragment(
     const GumboTag fragment_ctx, const GumboNamespaceEnum fragment_namespace) {
   GumboParser parser;
   parser._options = options;
+  // everything allocated from here on comes from the arena when asked to
+  GumboArena* arena = options->use_arena ? gumbo_arena_create() : NULL;
+  GumboArena* previous_arena = gumbo_arena_swap(arena);
   parser_state_init(&parser);
   // Must come after parser_state_init, since creating the document node must
   // reference parser_state->_current_node.
   output_init(&parser);
+  parser._output->arena = arena;
   // And this must come after output_init, because initializing the tokenizer
   // reads the first character and that may cause a UTF-8 decode error
   // (inserting into output->errors) if that's invalid.
@@ -4710,6 +4716,7 @@ GumboOutput* gumbo_parse_fragment(
 
   parser_state_destroy(&parser);
   gumbo_tokenizer_state_destroy(&parser);
+  gumbo_arena_swap(previous_arena);
   return parser._output;
 }
 
@@ -4728,12 +4735,22 @@ const char* gumbo_status_to_string(GumboOutputStatus status) {
 
 
 void gumbo_destroy_output(GumboOutput* output) {
+  GumboArena* arena = output->arena;
+  // The arena holds everything the parse allocated, output included, so
+  // the tree only needs walking if blocks from elsewhere were put in it
+  if (arena && !gumbo_arena_has_foreign_blocks(arena)) {
+    gumbo_arena_destroy(arena);
+    return;
+  }
   free_node(output->document);
   for (unsigned int i = 0; i < output->errors.length; ++i) {
     gumbo_error_destroy(output->errors.data[i]);
   }
   gumbo_vector_destroy(&output->errors);
   gumbo_free(output);
+  if (arena) {
+    gumbo_arena_destroy(arena);
+  }
 }
 
 GumboNode *gumbo_create_node(GumboNodeType type) {
@@ -48,6 +48,188 @@ void gumbo_memory_set_free(void (*free_p)(void *))
   gumbo_user_free = free_p ? free_p : free;
 }
 
+#if defined(_MSC_VER)
+#define GUMBO_THREAD_LOCAL __declspec(thread)
+#else
+#define GUMBO_THREAD_LOCAL __thread
+#endif
+
+typedef struct {
+  GumboArena* arena;
+  size_t size;
+} GumboBlockHeader;
+
+typedef struct GumboInternalArenaChunk {
+  struct GumboInternalArenaChunk* next;
+  size_t size;
+  size_t used;
+} GumboArenaChunk;
+
+struct GumboInternalArena {
+  // the chunk being carved up, linked to all of the older ones
+  GumboArenaChunk* chunk;
+  // the most recent block carved from chunk, it alone can grow in place
+  GumboBlockHeader* last;
+  size_t next_chunk_size;
+  bool has_foreign_blocks;
+};
+
+#define GUMBO_ALIGN sizeof(GumboBlockHeader)
+#define GUMBO_ALIGN_UP(n) (((n) + GUMBO_ALIGN - 1) & ~(GUMBO_ALIGN - 1))
+#define GUMBO_CHUNK_HEADER_SIZE GUMBO_ALIGN_UP(sizeof(GumboArenaChunk))
+#define GUMBO_ARENA_FIRST_CHUNK (32 * 1024)
+#define GUMBO_ARENA_MAX_CHUNK (1024 * 1024)
+
+static GUMBO_THREAD_LOCAL GumboArena* current_arena = NULL;
+
+static inline char* chunk_data(GumboArenaChunk* chunk) {
+  return (char*) chunk + GUMBO_CHUNK_HEADER_SIZE;
+}
+
+static inline size_t block_size(size_t size) {
+  return GUMBO_ALIGN_UP(sizeof(GumboBlockHeader) + size);
+}
+
+static GumboArenaChunk* new_chunk(size_t size) {
+  GumboArenaChunk* chunk = gumbo_user_allocator(NULL, GUMBO_CHUNK_HEADER_SIZE + size);
+  chunk->next = NULL;
+  chunk->size = size;
+  chunk->used = 0;
+  return chunk;
+}
+
+static GumboBlockHeader* arena_alloc(GumboArena* arena, size_t size) {
+  size_t need = block_size(size);
+  GumboArenaChunk* chunk = arena->chunk;
+  GumboBlockHeader* header;
+  if (need > arena->next_chunk_size / 2) {
+    // big blocks get a chunk of their own behind the current one
+    GumboArenaChunk* own = new_chunk(need);
+    own->used = need;
+    if (chunk) {
+      own->next = chunk->next;
+      chunk->next = own;
+    } else {
+      arena->chunk = own;
+    }
+    header = (GumboBlockHeader*) chunk_data(own);
+  } else {
+    if (!chunk || (chunk->size - chunk->used < need)) {
+      chunk = new_chunk(arena->next_chunk_size);
+      chunk->next = arena->chunk;
+      arena->chunk = chunk;
+      if (arena->next_chunk_size < GUMBO_ARENA_MAX_CHUNK) {
+        arena->next_chunk_size *= 2;
+      }
+    }
+    header = (GumboBlockHeader*) (chunk_data(chunk) + chunk->used);
+    chunk->used += need;
+    arena->last = header;
+  }
+  header->arena = arena;
+  header->size = size;
+  return header;
+}
+
+// the size kept in an arena block's header is its capacity, a
+// shrinking realloc leaves it be and copies never lose anything
+static void* arena_realloc(GumboBlockHeader* header, size_t size) {
+  GumboArena* arena = header->arena;
+  if (size <= header->size) {
+    return header + 1;
+  }
+  if (header == arena->last) {
+    GumboArenaChunk* chunk = arena->chunk;
+    size_t start = (char*) header - chunk_data(chunk);
+    if (chunk->size - start >= block_size(size)) {
+      chunk->used = start + block_size(size);
+      header->size = size;
+      return header + 1;
+    }
+  }
+  GumboBlockHeader* moved = arena_alloc(arena, size);
+  memcpy(moved + 1, header + 1, header->size);
+  return moved + 1;
+}
+
+void* gumbo_malloc(size_t size) {
+  GumboBlockHeader* header;
+  if (current_arena) {
+    return arena_alloc(current_arena, size) + 1;
+  }
+  header = gumbo_user_allocator(NULL, sizeof(GumboBlockHeader) + size);
+  header->arena = NULL;
+  header->size = size;
+  return header + 1;
+}
+
+void* gumbo_realloc(void* ptr, size_t size) {
+  if (!ptr) {
+    return gumbo_malloc(size);
+  }
+  GumboBlockHeader* header = (GumboBlockHeader*) ptr - 1;
+  if (header->arena) {
+    return arena_realloc(header, size);
+  }
+  header = gumbo_user_allocator(header, sizeof(GumboBlockHeader) + size);
+  header->size = size;
+  return header + 1;
+}
+
+void gumbo_free(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  GumboBlockHeader* header = (GumboBlockHeader*) ptr - 1;
+  GumboArena* arena = header->arena;
+  if (!arena) {
+    gumbo_user_free(header);
+  } else if (header == arena->last) {
+    // short lived buffers are common enough to be worth taking back
+    arena->chunk->used = (char*) header - chunk_data(arena->chunk);
+    arena->last = NULL;
+  }
+}
+
+GumboArena* gumbo_arena_create(void) {
+  GumboArena* arena = gumbo_user_allocator(NULL, sizeof(GumboArena));
+  arena->chunk = NULL;
+  arena->last = NULL;
+  arena->next_chunk_size = GUMBO_ARENA_FIRST_CHUNK;
+  arena->has_foreign_blocks = false;
+  return arena;
+}
+
+void gumbo_arena_destroy(GumboArena* arena) {
+  GumboArenaChunk* chunk = arena->chunk;
+  while (chunk) {
+    GumboArenaChunk* next = chunk->next;
+    gumbo_user_free(chunk);
+    chunk = next;
+  }
+  gumbo_user_free(arena);
+}
+
+GumboArena* gumbo_arena_swap(GumboArena* arena) {
+  GumboArena* previous = current_arena;
+  current_arena = arena;
+  return previous;
+}
+
+GumboArena* gumbo_arena_of(const void* ptr) {
+  return ((const GumboBlockHeader*) ptr - 1)->arena;
+}
+
+void gumbo_arena_adopt(GumboArena* arena, const void* ptr) {
+  if (arena && (gumbo_arena_of(ptr) != arena)) {
+    arena->has_foreign_blocks = true;
+  }
+}
+
+bool gumbo_arena_has_foreign_blocks(const GumboArena* arena) {
+  return arena->has_foreign_blocks;
+}
+
 bool gumbo_isspace(unsigned char ch) 
 {
   switch(ch) {
@@ -34,15 +34,21 @@ extern "C" {
 extern void *(* gumbo_user_allocator)(void *, size_t);
 extern void (* gumbo_user_free)(void *);
 
-static inline void *gumbo_malloc(size_t size)
-{
-  return gumbo_user_allocator(NULL, size);
-}
+// Every block handed out by gumbo_malloc carries a small header naming the
+// arena it was carved from (NULL if it came from gumbo_user_allocator), so
+// that gumbo_realloc and gumbo_free always do the right thing with it.
+//
+// While a thread has a current arena all new blocks come from it, this is
+// how a parse with GumboOptions::use_arena set keeps all of its memory
+// together.  Blocks are never returned to an arena one at a time (except
+// for the most recent one), the arena is released all at once instead.
+typedef struct GumboInternalArena GumboArena;
 
-static inline void *gumbo_realloc(void *ptr, size_t size)
-{
-  return gumbo_user_allocator(ptr, size);
-}
+void *gumbo_malloc(size_t size);
+
+void *gumbo_realloc(void *ptr, size_t size);
+
+void gumbo_free(void *ptr);
 
 static inline char *gumbo_strdup(const char *str)
 {
@@ -52,10 +58,24 @@ static inline char *gumbo_strdup(const char *str)
   return copy;
 }
 
-static inline void gumbo_free(void *ptr)
-{
-  gumbo_user_free(ptr);
-}
+GumboArena *gumbo_arena_create(void);
+
+// releases every block ever carved from the arena
+void gumbo_arena_destroy(GumboArena *arena);
+
+// makes arena (or NULL for none) the current thread's arena for new
+// blocks and returns the one it replaces so that it can be restored
+GumboArena *gumbo_arena_swap(GumboArena *arena);
+
+// the arena a block from gumbo_malloc belongs to, NULL if none
+GumboArena *gumbo_arena_of(const void *ptr);
+
+// records that the block at ptr is now referenced from the arena's blocks,
+// so if it was allocated elsewhere the arena can no longer simply be
+// released without first freeing what it points at
+void gumbo_arena_adopt(GumboArena *arena, const void *ptr);
+
+bool gumbo_arena_has_foreign_blocks(const GumboArena *arena);
 
 static inline int gumbo_tolower(int c)
 {
@@ -30,6 +30,8 @@
 #include "BookManipulation/Book.h"
 #include "BookManipulation/CleanSource.h"
 #include "BookManipulation/FolderKeeper.h"
+#include "BookManipulation/HTMLIndex.h"
+#include "BookManipulation/LinkDependencies.h"
 #include "Parsers/GumboInterface.h"
 #include "Parsers/CSSToolbox.h"
 #include "Misc/TempFolder.h"
@@ -224,12 +226,14 @@ const QString HTML5_COVER_SOURCE =
 Book::Book()
     :
     m_Mainfolder(new FolderKeeper(this)),
+    m_LinkDependencies(new LinkDependencies()),
     m_IsModified(false)
 {
 }
 
 Book::~Book()
 {
+    delete m_LinkDependencies;
     delete m_Mainfolder;
 }
 
@@ -693,9 +697,7 @@ void Book::CreateNewSections(const QStringList &new_sections, HTMLResource *orig
 
 bool Book::IsDataWellFormed(HTMLResource *html_resource)
 {
-    XhtmlDoc::WellFormedError error = XhtmlDoc::WellFormedErrorForSource(html_resource->GetText(), 
-                                                                         html_resource->GetEpubVersion());
-    return error.line == -1;
+    return html_resource->IsWellFormed(html_resource->GetEpubVersion());
 }
 
 
@@ -815,7 +817,7 @@ std::tuple<QString, QStringList> Book::GetStyleUrlsInHTMLFileMapped(HTMLResource
     QString html_bookpath = html_resource->GetRelativePath();
     QString startdir = html_resource->GetFolder();
     // we need to convert this hreflist to bookpaths if possible
-    QStringList urllist = XhtmlDoc::GetAllDescendantStyleUrls(html_resource->GetText());
+    QStringList urllist = html_resource->GetHTMLIndex()->StyleUrls();
     QStringList bookpaths;
     QRegularExpression url_file_search("url\\s*\\(\\s*['\"]?([^\\(\\)'\"]*)[\"']?\\)");
     foreach (QString url, urllist) {
@@ -850,12 +852,12 @@ QHash<QString, QStringList> Book::GetIdsInHTMLFiles()
 std::tuple<QString, QStringList> Book::GetIdsInHTMLFileMapped(HTMLResource *html_resource)
 {
     return std::make_tuple(html_resource->GetRelativePath(),
-                           XhtmlDoc::GetAllDescendantIDs(html_resource->GetText()));
+                           html_resource->GetHTMLIndex()->IDs());
 }
 
 QStringList Book::GetIdsInHTMLFile(HTMLResource *html_resource)
 {
-    return XhtmlDoc::GetAllDescendantIDs(html_resource->GetText());
+    return html_resource->GetHTMLIndex()->IDs();
 }
 
 
@@ -903,12 +905,12 @@ QHash<QString, QStringList> Book::GetHrefsInHTMLFiles()
 std::tuple<QString, QStringList> Book::GetHrefsInHTMLFileMapped(HTMLResource *html_resource)
 {
     return std::make_tuple(html_resource->GetRelativePath(),
-                           XhtmlDoc::GetAllDescendantHrefs(html_resource->GetText()));
+                           html_resource->GetHTMLIndex()->Hrefs());
 }
 
 QStringList Book::GetClassesInHTMLFile(HTMLResource *html_resource)
 {
-    return XhtmlDoc::GetAllDescendantClasses(html_resource->GetText());
+    return html_resource->GetHTMLIndex()->Classes();
 }
 
 QHash<QString, QStringList> Book::GetImagesInHTMLFiles()
@@ -1024,8 +1026,7 @@ std::tuple<QString, QStringList> Book::GetMediaInHTMLFileMapped(HTMLResource *ht
 {
     QString html_bookpath = html_resource->GetRelativePath();
     QString startdir = html_resource->GetFolder();
-    QStringList media_hrefs = XhtmlDoc::GetAllMediaPathsFromMediaChildren(html_resource->GetText(), 
-                                                                       GIMAGE_TAGS + GVIDEO_TAGS + GAUDIO_TAGS);
+    QStringList media_hrefs = html_resource->GetHTMLIndex()->MediaPaths();
     QStringList media_bookpaths;
     foreach(QString ahref, media_hrefs) {
         if (ahref.indexOf(":") == -1) {
@@ -1039,7 +1040,7 @@ std::tuple<QString, QStringList> Book::GetImagesInHTMLFileMapped(HTMLResource *h
 {
     QString html_bookpath = html_resource->GetRelativePath();
     QString startdir = html_resource->GetFolder();
-    QStringList image_hrefs = XhtmlDoc::GetAllMediaPathsFromMediaChildren(html_resource->GetText(), GIMAGE_TAGS);
+    QStringList image_hrefs = html_resource->GetHTMLIndex()->ImagePaths();
     QStringList image_bookpaths;
     foreach(QString ahref, image_hrefs) {
         if (ahref.indexOf(":") == -1) {
@@ -1053,7 +1054,7 @@ std::tuple<QString, QStringList> Book::GetVideoInHTMLFileMapped(HTMLResource *ht
 {
     QString html_bookpath = html_resource->GetRelativePath();
     QString startdir = html_resource->GetFolder();
-    QStringList video_hrefs = XhtmlDoc::GetAllMediaPathsFromMediaChildren(html_resource->GetText(), GVIDEO_TAGS);
+    QStringList video_hrefs = html_resource->GetHTMLIndex()->VideoPaths();
     QStringList video_bookpaths;
     foreach(QString ahref, video_hrefs) {
         if (ahref.indexOf(":") == -1) {
@@ -1067,7 +1068,7 @@ std::tuple<QString, QStringList> Book::GetAudioInHTMLFileMapped(HTMLResource *ht
 {
     QString html_bookpath = html_resource->GetRelativePath();
     QString startdir = html_resource->GetFolder();
-    QStringList audio_hrefs = XhtmlDoc::GetAllMediaPathsFromMediaChildren(html_resource->GetText(), GAUDIO_TAGS);
+    QStringList audio_hrefs = html_resource->GetHTMLIndex()->AudioPaths();
     QStringList audio_bookpaths;
     foreach(QString ahref, audio_hrefs) {
         if (ahref.indexOf(":") == -1) {
@@ -1181,7 +1182,7 @@ std::tuple<QString, QStringList> Book::GetStylesheetsInHTMLFileMapped(HTMLResour
 {
     QString html_bookpath = html_resource->GetRelativePath();
     QString startdir = html_resource->GetFolder();
-    QStringList link_hrefs = XhtmlDoc::GetLinkedStylesheets(html_resource->GetText());
+    QStringList link_hrefs = html_resource->GetHTMLIndex()->LinkedStylesheets();
     QStringList link_bookpaths;
     foreach(QString ahref, link_hrefs) {
         if (ahref.indexOf(":") == -1) {
@@ -1195,7 +1196,7 @@ std::tuple<QString, QStringList> Book::GetStylesheetsInHTMLFileMapped(HTMLResour
 QStringList Book::GetStylesheetsInHTMLFile(HTMLResource *html_resource)
 {
     // convert encoded links relative to a html resource to their book paths
-    QStringList stylelinks = XhtmlDoc::GetLinkedStylesheets(html_resource->GetText());
+    QStringList stylelinks = html_resource->GetHTMLIndex()->LinkedStylesheets();
     QStringList results;
     QString html_folder = html_resource->GetFolder();
     foreach(QString stylelink, stylelinks) {
@@ -1363,6 +1364,25 @@ QList <Resource *> Book::GetAllResources()
     return m_Mainfolder->GetResourceList();
 }
 
+
+QList <Resource *> Book::GetResourcesToUpdate(const QHash<QString, QString> &updates)
+{
+    QList<Resource *> resources = m_Mainfolder->GetResourceList();
+    QSet<Resource *> linking = m_LinkDependencies->ResourcesLinkingTo(resources, updates.keys());
+    QSet<QString> new_bookpaths(updates.cbegin(), updates.cend());
+    QList<Resource *> to_update;
+    foreach(Resource * resource, resources) {
+        if ((resource->Type() == Resource::HTMLResourceType) || (resource->Type() == Resource::CSSResourceType)) {
+            // a file that moved must have its own links updated
+            if (!linking.contains(resource) && !new_bookpaths.contains(resource->GetRelativePath())) {
+                continue;
+            }
+        }
+        to_update.append(resource);
+    }
+    return to_update;
+}
+
 void Book::SaveAllResourcesToDisk()
 {
     QList<Resource *> resources = m_Mainfolder->GetResourceList();
@@ -1526,22 +1546,9 @@ QPair<QString, QStringList> Book::GetRelLinksInOneFile(HTMLResource *html_resour
 {
     Q_ASSERT(html_resource);
     QReadLocker locker(&html_resource->GetLock());
-    QString htmldir = html_resource->GetFolder();
-    GumboInterface gi = GumboInterface(html_resource->GetText(), html_resource->GetEpubVersion());
-    gi.parse();
     QPair<QString, QStringList> link_pair;
-    QStringList hreflist;
-    const QList<GumboNode*> anchor_nodes = gi.get_all_nodes_with_tag(GUMBO_TAG_A);
-    for (int i = 0; i < anchor_nodes.length(); ++i) {
-        GumboNode* node = anchor_nodes.at(i);
-        GumboAttribute* attr = gumbo_get_attribute(&node->v.element.attributes, "href");
-        // We find the hrefs that are relative and contain an href.
-        if (attr && QUrl(QString::fromUtf8(attr->value)).isRelative()) {
-            hreflist.append(QString::fromStdString(attr->value));
-        }
-    }
     link_pair.first = html_resource->GetRelativePath();
-    link_pair.second = hreflist;
+    link_pair.second = html_resource->GetHTMLIndex()->RelativeAnchorHrefs();
     return link_pair;
 }
 
@@ -1550,13 +1557,8 @@ QPair<QString, QStringList> Book::GetOneFileIDs(HTMLResource *html_resource)
 {
     Q_ASSERT(html_resource);
     QReadLocker locker(&html_resource->GetLock());
-    QString newsource = html_resource->GetText();
-    QString version = html_resource->GetEpubVersion();
-    GumboInterface gi = GumboInterface(newsource, version);
-    gi.parse();
     QPair<QString, QStringList> id_pair;
-    QStringList ids = gi.get_all_values_for_attribute(QString("id"));
     id_pair.first = html_resource->GetRelativePath();
-    id_pair.second = ids;
+    id_pair.second = html_resource->GetHTMLIndex()->IDAttributes();
     return id_pair;
 }
@@ -36,6 +36,7 @@
 class CSSResource;
 class SVGResource;
 class FolderKeeper;
+class LinkDependencies;
 class HTMLResource;
 class NCXResource;
 class OPFResource;
@@ -267,6 +268,14 @@ public:
 
     QList <Resource *> GetAllResources();
 
+    /**
+     * Returns the resources UniversalUpdates must be run on for the
+     * given old to new book path updates: the OPF, the NCX, all other
+     * xml files, and only those html and css files that either moved
+     * themselves or link to one of the old book paths.
+     */
+    QList <Resource *> GetResourcesToUpdate(const QHash<QString, QString> &updates);
+
     /**
      * Makes sure that all the resources have saved the state of
      * their caches to the disk.
@@ -441,6 +450,11 @@ private:
      */
     FolderKeeper *m_Mainfolder;
 
+    /**
+     * Which html and css files link to which book paths.
+     */
+    LinkDependencies *m_LinkDependencies;
+
     /**
      * Stores the modified state of the book.
      */
@@ -36,8 +36,7 @@
 #include "Parsers/CSSInfo.h"
 #include "Parsers/HTMLStyleInfo.h"
 #include "Parsers/GumboInterface.h"
-#include "Query/CSelection.h"
-#include "Query/CNode.h"
+#include "Parsers/CompiledSelectorSet.h"
 #include "Misc/SettingsStore.h"
 #include "Misc/Utility.h"
 
@@ -159,12 +158,22 @@ QList<BookReports::StyleData *> BookReports::GetAllCSSSelectorsUsed(QSharedPoint
         }
     }
 
+    // Parse each of their selectors with the Query parser only once for the whole report
+    QHash<QString, CompiledSelectorSet *> css_selectors;
+    foreach(QString css_filename, css_parsers.keys()) {
+        CompiledSelectorSet *selset = new CompiledSelectorSet();
+        foreach(CSSInfo::CSSSelector * selector, css_parsers[css_filename]->getAllSelectors()) {
+            selset->Add(selector->text);
+        }
+        css_selectors[css_filename] = selset;
+    }
+
     QList<HTMLResource *> html_resources = book->GetFolderKeeper()->GetResourceTypeList<HTMLResource>(false);
 
     QFuture< QList< std::pair<QString,QString> > > usage_future;
     usage_future = QtConcurrent::mapped(html_resources,
                                         std::bind(AllSelectorsUsedInHTMLFileMapped,
-                                                  std::placeholders::_1, css_parsers));
+                                                  std::placeholders::_1, css_parsers, css_selectors));
 
     int num_futures = usage_future.results().count();
     for (int i = 0; i < num_futures; ++i) {
@@ -222,59 +231,71 @@ QList<BookReports::StyleData *> BookReports::GetAllCSSSelectorsUsed(QSharedPoint
         delete cp;
     }
     css_parsers.clear();
+    qDeleteAll(css_selectors);
+    css_selectors.clear();
 
     return css_selector_usage;
 }
 
 
 QList< std::pair<QString,QString> > BookReports::AllSelectorsUsedInHTMLFileMapped(HTMLResource* html_resource,
-                                                                          const QHash<QString, CSSInfo *> &css_parsers)
+                                                                          const QHash<QString, CSSInfo *> &css_parsers,
+                                                                          const QHash<QString, CompiledSelectorSet *> &css_selectors)
 {
     QList< std::pair<QString, QString> > selectors_used;
 
-    QStringList linked_stylesheets = html_resource->GetLinkedStylesheets();
-    
-    GumboInterface gi = GumboInterface(html_resource->GetText(), "any_version");
-    
-    // Look at each selector from linked CSS files and internal html style tags
-    // and see if they match something in this html file
+    QString source = html_resource->GetText();
+    QString html_filename = html_resource->GetRelativePath();
+
+    // Collect the selectors from linked CSS files and internal html style tags
+    // so that all of them can be tested against this html file in one walk
     // file names are all bookpaths
+    QStringList set_filenames;
+    QList< QList<CSSInfo::CSSSelector *> > set_selectors;
+    QList<const CompiledSelectorSet *> sets;
 
-    foreach(QString css_filename, linked_stylesheets) {
-        if (css_parsers.contains(css_filename)) {
-            CSSInfo * cp = css_parsers[css_filename];
-            QList<CSSInfo::CSSSelector *> selectors = cp->getAllSelectors();
-            foreach(CSSInfo::CSSSelector * selector, selectors) {
-                // Use Gumbo Query Library to see if selector is found
-                CSelection c = gi.find(selector->text);
-                // if Query selector parse error occurs to be most safe
-                // assume this selector is used in this file
-                std::pair<QString, QString> res;
-                QString foundin = html_resource->GetRelativePath();
-                if (c.parseError()) foundin = "*** Selector Parse Error ***";
-                if (c.parseError() || (c.nodeNum() > 0 && c.nodeAt(0).valid())) {
-                    res.first = css_filename + USEP + QString::number(selector->pos) + USEP + selector->text;
-                    res.second = foundin;
-                    selectors_used.append(res);
-                }
-            }
+    foreach(QString css_filename, html_resource->GetLinkedStylesheets()) {
+        if (css_parsers.contains(css_filename) && !set_filenames.contains(css_filename)) {
+            set_filenames << css_filename;
+            set_selectors << css_parsers[css_filename]->getAllSelectors();
+            sets << css_selectors[css_filename];
         }
     }
 
-    // now look for internal <style> tags in this HTML File and test their selectors as well
-    HTMLStyleInfo hp(html_resource->GetText());
+    // internal <style> tags only apply to this file so compile them here
+    HTMLStyleInfo hp(source);
+    CompiledSelectorSet style_set;
     if (hp.hasStyles()) {
         QList<CSSInfo::CSSSelector *> selectors = hp.getAllSelectors();
         foreach(CSSInfo::CSSSelector * selector, selectors) {
-            CSelection c = gi.find(selector->text);
+            style_set.Add(selector->text);
+        }
+        set_filenames << html_filename;
+        set_selectors << selectors;
+        sets << &style_set;
+    }
+
+    if (sets.isEmpty()) return selectors_used;
+
+    QList< std::vector<bool> > used;
+    if (!source.isEmpty()) {
+        GumboInterface gi = GumboInterface(source, "any_version");
+        CompiledSelectorSet::FindUsed(gi.get_root_node(), sets, used);
+    } else {
+        CompiledSelectorSet::FindUsed(NULL, sets, used);
+    }
+
+    for (int i = 0; i < sets.count(); i++) {
+        const QList<CSSInfo::CSSSelector *> &selectors = set_selectors.at(i);
+        for (int j = 0; j < selectors.count(); j++) {
+            CSSInfo::CSSSelector *selector = selectors.at(j);
             // if Query selector parse error occurs to be most safe
             // assume this selector is used in this file
-            std::pair<QString, QString> res;
-            QString foundin = html_resource->GetRelativePath();
-            if (c.parseError()) foundin = "*** Selector Parse Error ***";
-            if (c.parseError() || (c.nodeNum() > 0 && c.nodeAt(0).valid())) {
-                res.first = html_resource->GetRelativePath() + USEP + QString::number(selector->pos) + USEP + selector->text;
-                res.second = foundin;
+            bool parse_error = sets.at(i)->ParseError(j);
+            if (parse_error || used.at(i).at(j)) {
+                std::pair<QString, QString> res;
+                res.first = set_filenames.at(i) + USEP + QString::number(selector->pos) + USEP + selector->text;
+                res.second = parse_error ? "*** Selector Parse Error ***" : html_filename;
                 selectors_used.append(res);
             }
         }
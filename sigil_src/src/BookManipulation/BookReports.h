@@ -27,6 +27,7 @@
 #include "ResourceObjects/HTMLResource.h"
 #include "ResourceObjects/CSSResource.h"
 #include "Parsers/CSSInfo.h"
+#include "Parsers/CompiledSelectorSet.h"
 #include "BookManipulation/Book.h"
 
 
@@ -59,7 +60,8 @@ public:
                                                                   bool show_progress = false);
 
     static QList< std::pair<QString,QString> > AllSelectorsUsedInHTMLFileMapped(HTMLResource* html_resource,
-                                                                            const QHash<QString, CSSInfo*> &css_parsers);
+                                                                            const QHash<QString, CSSInfo*> &css_parsers,
+                                                                            const QHash<QString, CompiledSelectorSet*> &css_selectors);
 
 
 };
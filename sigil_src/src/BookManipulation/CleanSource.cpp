@@ -22,28 +22,44 @@
 
 #include "EmbedPython/EmbeddedPython.h"
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
+#include <QtCore/QDebug>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QStringView>
 #include <QtCore/QWriteLocker>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QProgressDialog>
+#include <QtConcurrent/QtConcurrent>
 #include <QRegularExpression>
 #include <QRegularExpressionMatch>
 
 #include "BookManipulation/CleanSource.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Parsers/GumboInterface.h"
+#include "Parsers/NativeXMLProcessor.h"
+#include "Misc/FutureProgress.h"
 #include "Misc/SettingsStore.h"
 #include "sigil_constants.h"
 #include "sigil_exception.h"
 #include "Misc/Utility.h"
+#include <cstring>
 #include <utility>
+#include <vector>
 
 static const QString HEAD_END = "</\\s*head\\s*>";
 const QString SVG_NAMESPACE_PREFIX = "<\\s*[^>]*(xmlns\\s*:\\s*svg\\s*=\\s*(?:\"|')[^\"']+(?:\"|'))[^>]*>";
 
 static const QStringList NUMERIC_NBSP = QStringList() << "&#160;" << "&#xa0;" << "&#x00a0;";
 
+// allow the native xml processor to be bypassed or checked against bs4
+static const bool USE_NATIVE_XML_PROCESSING = !qEnvironmentVariableIsSet("SIGIL_DISABLE_NATIVE_XML_PROCESSING");
+static const bool VERIFY_NATIVE_XML_PROCESSING = qEnvironmentVariableIsSet("SIGIL_VERIFY_NATIVE_XML_PROCESSING");
+
 
 // Performs general cleaning (and improving)
 // of provided book XHTML source code
@@ -166,6 +182,21 @@ QString CleanSource::ProcessXML(const QString &source, const QString mtype)
             return source;
         }
     }
+    // well-formed xml is handled natively without needing python,
+    // only xml that actually needs repair is sent to bs4
+    QString result;
+    if (USE_NATIVE_XML_PROCESSING && NativeXMLProcessor::RepairXML(source, mtype, result)) {
+        if (!VERIFY_NATIVE_XML_PROCESSING) {
+            return result;
+        }
+        QString bs4result = XMLPrettyPrintBS4(source, mtype);
+        if (result != bs4result) {
+            qWarning() << "ProcessXML: native and bs4 results differ for " << mtype;
+            qWarning() << "native: " << result;
+            qWarning() << "bs4: " << bs4result;
+        }
+        return bs4result;
+    }
     return XMLPrettyPrintBS4(source, mtype);
 }
 
@@ -263,55 +294,191 @@ QString CleanSource::PrettifyDOCTYPEHeader(const QString &source)
 }
 
 
-QString CleanSource::CharToEntity(const QString &source, const QString &version)
+// The preserved characters and what each becomes for one epub version.
+//
+// Replacing one character by a string in turn for each preserved entity
+// maps every character of the source independently, so the whole series
+// of replacements is the same as replacing each character by what that
+// series of replacements makes of it alone.  So one table lookup per
+// replaced character gives exactly what the replacements in turn did.
+struct EntityTable {
+    // one bit for each utf-16 code unit that is replaced
+    std::vector<quint64> replaced;
+    QHash<ushort, QString> expansions;
+    bool has_ascii;
+};
+
+static QMutex entity_table_mutex;
+static int entity_table_revision = -1;
+static QSharedPointer<const EntityTable> entity_tables[2];
+
+
+static QSharedPointer<const EntityTable> BuildEntityTable(const QList<std::pair <ushort, QString>> &codenames,
+                                                          bool epub3)
 {
-    SettingsStore settings;
-    QString new_source = source;
-    QList<std::pair <ushort, QString>> codenames = settings.preserveEntityCodeNames();
-    std::pair <ushort, QString> epair;
     bool has_numeric_nbsp = false;
-    foreach(epair, codenames) {
+    foreach(auto epair, codenames) {
         QString codename = epair.second.toLower();
         if (NUMERIC_NBSP.contains(codename)) {
             has_numeric_nbsp = true;
-        } 
+        }
     }
-    // now intelligently handle the replacements
-    foreach(epair, codenames) {
+    // the replacements in the order they were made
+    QList<std::pair <ushort, QString>> replacements;
+    foreach(auto epair, codenames) {
         QString codename = epair.second.toLower();
-        if (version.startsWith("2")) {
-            new_source.replace(QChar(epair.first), codename);
-        } else if (version.startsWith("3")) {
+        if (!epub3) {
+            replacements.append(std::make_pair(epair.first, codename));
+        } else if (codename.startsWith("&#")) {
             // only use numeric entities in epub3
-            if (codename.startsWith("&#")) { 
-                new_source.replace(QChar(epair.first), codename);
-            } else if ((codename == "&nbsp;") && !has_numeric_nbsp) {
-                new_source.replace(QChar(epair.first), "&#160;");
+            replacements.append(std::make_pair(epair.first, codename));
+        } else if ((codename == "&nbsp;") && !has_numeric_nbsp) {
+            replacements.append(std::make_pair(epair.first, QString("&#160;")));
+        }
+    }
+
+    EntityTable *table = new EntityTable();
+    table->replaced.assign(65536 / 64, 0);
+    table->has_ascii = false;
+    foreach(auto rpair, replacements) {
+        ushort code = rpair.first;
+        if (table->expansions.contains(code)) {
+            continue;
+        }
+        QString expansion = QString(QChar(code));
+        foreach(auto r, replacements) {
+            expansion.replace(QChar(r.first), r.second);
+        }
+        if (expansion == QString(QChar(code))) {
+            continue;
+        }
+        table->expansions.insert(code, expansion);
+        table->replaced[code >> 6] |= Q_UINT64_C(1) << (code & 63);
+        if (code < 0x80) {
+            table->has_ascii = true;
+        }
+    }
+    return QSharedPointer<const EntityTable>(table);
+}
+
+
+// only rebuilt when the preserved entities preference changes
+static QSharedPointer<const EntityTable> GetEntityTable(bool epub3)
+{
+    // read the revision before the settings so a concurrent
+    // change can only ever cause an extra rebuild
+    int revision = SettingsStore::preserveEntityCodeNamesRevision();
+    QMutexLocker locker(&entity_table_mutex);
+    if (revision != entity_table_revision) {
+        SettingsStore settings;
+        QList<std::pair <ushort, QString>> codenames = settings.preserveEntityCodeNames();
+        entity_tables[0] = BuildEntityTable(codenames, false);
+        entity_tables[1] = BuildEntityTable(codenames, true);
+        entity_table_revision = revision;
+    }
+    return entity_tables[epub3 ? 1 : 0];
+}
+
+
+// returns the position of the next code unit at or after pos to be
+// replaced, or end if there is none, skipping four ascii code units
+// at a time when no ascii character is ever replaced
+static int NextReplaced(const ushort *data, int pos, int end, const EntityTable *table)
+{
+    const quint64 NON_ASCII = Q_UINT64_C(0xFF80FF80FF80FF80);
+    while (pos < end) {
+        if (!table->has_ascii) {
+            while (pos + 4 <= end) {
+                quint64 units;
+                memcpy(&units, data + pos, sizeof(units));
+                if (units & NON_ASCII) {
+                    break;
+                }
+                pos += 4;
+            }
+            if (pos == end) {
+                break;
             }
         }
+        ushort c = data[pos];
+        if (table->replaced[c >> 6] & (Q_UINT64_C(1) << (c & 63))) {
+            return pos;
+        }
+        pos++;
+    }
+    return end;
+}
+
+
+QString CleanSource::CharToEntity(const QString &source, const QString &version)
+{
+    bool epub3;
+    if (version.startsWith("2")) {
+        epub3 = false;
+    } else if (version.startsWith("3")) {
+        epub3 = true;
+    } else {
+        return source;
+    }
+    QSharedPointer<const EntityTable> table = GetEntityTable(epub3);
+    if (table->expansions.isEmpty()) {
+        return source;
+    }
+
+    const ushort *data = source.utf16();
+    int end = source.length();
+    int pos = NextReplaced(data, 0, end, table.data());
+    if (pos == end) {
+        return source;
+    }
+
+    QString new_source;
+    new_source.reserve(end + end / 16 + 16);
+    int last = 0;
+    while (pos < end) {
+        new_source.append(QStringView(source).mid(last, pos - last));
+        new_source.append(table->expansions.value(data[pos]));
+        last = pos + 1;
+        pos = NextReplaced(data, last, end, table.data());
     }
+    new_source.append(QStringView(source).mid(last));
     return new_source;
 }
 
 
-bool CleanSource::ReformatAll(QList <HTMLResource *> resources, QString(clean_func)(const QString &source, const QString &version))
+// Cleans one file, returning true if its text was changed
+static bool ReformatOne(HTMLResource *resource, QString(clean_func)(const QString &source, const QString &version))
+{
+    QWriteLocker locker(&resource->GetLock());
+    QString source = resource->GetText();
+    QString version = resource->GetEpubVersion();
+    QString newsource = clean_func(source, version);
+    if (newsource != source) {
+        resource->SetText(newsource);
+        return true;
+    }
+    return false;
+}
+
+
+bool CleanSource::ReformatAll(QList <HTMLResource *> resources, QString(clean_func)(const QString &source, const QString &version), bool *canceled)
 {
-    QProgressDialog progress(QObject::tr("Cleaning..."), 0, 0, resources.count(), Utility::GetMainWindow());
+    QProgressDialog progress(QObject::tr("Cleaning..."), QObject::tr("Abort"), 0, resources.count(), Utility::GetMainWindow());
     progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
-    int progress_value = 0;
-    progress.setValue(progress_value);
-    bool book_modified = false;
-    foreach(HTMLResource * resource, resources) {
-        progress.setValue(progress_value++);
-        qApp->processEvents();
-        QWriteLocker locker(&resource->GetLock());
-        QString source = resource->GetText();
-        QString version = resource->GetEpubVersion();
-        QString newsource = clean_func(source, version);
-        if (newsource != source) {
-            book_modified = true;
-            resource->SetText(newsource);
+    progress.setValue(0);
+
+    // files are cleaned on a pool of threads; if canceled the files
+    // already cleaned keep their changes, and the results of a canceled
+    // future are dropped, so the workers note any change themselves
+    QAtomicInt book_modified(0);
+    QFuture<void> future = QtConcurrent::map(resources, [clean_func, &book_modified](HTMLResource *resource) {
+        if (ReformatOne(resource, clean_func)) {
+            book_modified.storeRelaxed(1);
         }
+    });
+    FutureProgress::Wait(future, progress);
+    if (canceled) {
+        *canceled = future.isCanceled();
     }
-    return book_modified;
+    return book_modified.loadRelaxed() != 0;
 }
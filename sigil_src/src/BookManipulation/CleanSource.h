@@ -53,7 +53,10 @@ public:
 
     static QString CharToEntity(const QString &source, const QString &version);
 
-    static bool ReformatAll(QList <HTMLResource *> resources, QString(clean_fun)(const QString &source, const QString &version));
+    // Returns true if any file was changed, even when the user aborts part way,
+    // and sets canceled (if given) to whether they did
+    static bool ReformatAll(QList <HTMLResource *> resources, QString(clean_fun)(const QString &source, const QString &version),
+                            bool *canceled = NULL);
 
     /** 
      * neither svg nor math tags need a namespace prefix defined
@@ -0,0 +1,108 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <cstring>
+#include <string>
+#include <unordered_set>
+#include <QUrl>
+#include <QRegularExpression>
+
+#include "BookManipulation/XhtmlDoc.h"
+#include "Parsers/GumboInterface.h"
+#include "BookManipulation/HTMLIndex.h"
+
+static const std::unordered_set<std::string> LINK_ATTRIBUTES = {
+    "href", "src", "poster", "data", "srcset", "altimg"
+};
+
+static const QRegularExpression STYLE_URL("url\\([\"']?([^\\(\\)\"']*)[\"']?\\)");
+
+
+static void AppendStyleUrls(const QString &style, QStringList &urls)
+{
+    if (!style.contains("url(")) return;
+    QRegularExpressionMatchIterator mi = STYLE_URL.globalMatch(style);
+    while (mi.hasNext()) {
+        urls.append(mi.next().captured(1));
+    }
+}
+
+
+// visits every element whatever its tag or namespace since gumbo's
+// serializer may rewrite these attributes anywhere
+static void CollectLinks(GumboNode *node, QStringList &values, QStringList &style_urls)
+{
+    if ((node->type != GUMBO_NODE_ELEMENT) && (node->type != GUMBO_NODE_TEMPLATE)) return;
+    GumboVector *attribs = &node->v.element.attributes;
+    for (unsigned int i = 0; i < attribs->length; ++i) {
+        GumboAttribute *attr = static_cast<GumboAttribute *>(attribs->data[i]);
+        if (LINK_ATTRIBUTES.count(attr->name)) {
+            values.append(QString::fromUtf8(attr->value));
+        } else if (strcmp(attr->name, "style") == 0) {
+            AppendStyleUrls(QString::fromUtf8(attr->value), style_urls);
+        }
+    }
+    GumboVector *children = &node->v.element.children;
+    bool is_style = node->v.element.tag == GUMBO_TAG_STYLE;
+    for (unsigned int i = 0; i < children->length; ++i) {
+        GumboNode *child = static_cast<GumboNode *>(children->data[i]);
+        if (is_style && ((child->type == GUMBO_NODE_TEXT) || (child->type == GUMBO_NODE_CDATA) ||
+                         (child->type == GUMBO_NODE_WHITESPACE))) {
+            AppendStyleUrls(QString::fromUtf8(child->v.text.text), style_urls);
+        }
+        CollectLinks(child, values, style_urls);
+    }
+}
+
+
+HTMLIndex::HTMLIndex(const QString &source)
+{
+    QString version = "any_version";
+    GumboInterface gi = GumboInterface(source, version);
+    gi.parse();
+
+    m_IDs = XhtmlDoc::GetAllDescendantIDs(gi);
+    m_IDAttributes = gi.get_all_values_for_attribute(QString("id"));
+    m_Hrefs = XhtmlDoc::GetAllDescendantHrefs(gi);
+    m_Classes = XhtmlDoc::GetAllDescendantClasses(gi);
+    m_StyleUrls = XhtmlDoc::GetAllDescendantStyleUrls(gi);
+    m_ImagePaths = XhtmlDoc::GetAllMediaPathsFromMediaChildren(gi, GIMAGE_TAGS);
+    m_VideoPaths = XhtmlDoc::GetAllMediaPathsFromMediaChildren(gi, GVIDEO_TAGS);
+    m_AudioPaths = XhtmlDoc::GetAllMediaPathsFromMediaChildren(gi, GAUDIO_TAGS);
+    m_MediaPaths = XhtmlDoc::GetAllMediaPathsFromMediaChildren(gi, GIMAGE_TAGS + GVIDEO_TAGS + GAUDIO_TAGS);
+
+    const QList<GumboNode*> anchor_nodes = gi.get_all_nodes_with_tag(GUMBO_TAG_A);
+    for (int i = 0; i < anchor_nodes.length(); ++i) {
+        GumboNode* node = anchor_nodes.at(i);
+        GumboAttribute* attr = gumbo_get_attribute(&node->v.element.attributes, "href");
+        // We find the hrefs that are relative and contain an href.
+        if (attr && QUrl(QString::fromUtf8(attr->value)).isRelative()) {
+            m_RelativeAnchorHrefs.append(QString::fromStdString(attr->value));
+        }
+    }
+
+    GumboNode *root = gi.get_root_node();
+    if (root) {
+        CollectLinks(root, m_LinkAttributeValues, m_AllStyleUrls);
+    }
+
+    m_LinkedStylesheets = XhtmlDoc::GetLinkedStylesheets(source);
+}
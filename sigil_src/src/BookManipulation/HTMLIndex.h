@@ -0,0 +1,95 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef HTMLINDEX_H
+#define HTMLINDEX_H
+
+#include <QString>
+#include <QStringList>
+
+// The ids, links, classes, and media references of one xhtml file,
+// all extracted from a single gumbo parse of its text (only the linked
+// stylesheets still come from XhtmlDoc's quick scan of the head).
+//
+// Each list holds exactly what the XhtmlDoc routine named beside it
+// returns for that text.  HTMLResource keeps one of these per text
+// revision so that book wide queries do not need to reparse every file.
+
+class HTMLIndex
+{
+public:
+
+    HTMLIndex(const QString &source);
+
+    // XhtmlDoc::GetAllDescendantIDs
+    const QStringList &IDs() const               { return m_IDs; }
+
+    // the values of every id attribute, in document order
+    const QStringList &IDAttributes() const      { return m_IDAttributes; }
+
+    // XhtmlDoc::GetAllDescendantHrefs
+    const QStringList &Hrefs() const             { return m_Hrefs; }
+
+    // the raw hrefs of all a tags whose href is relative
+    const QStringList &RelativeAnchorHrefs() const { return m_RelativeAnchorHrefs; }
+
+    // XhtmlDoc::GetAllDescendantClasses
+    const QStringList &Classes() const           { return m_Classes; }
+
+    // XhtmlDoc::GetAllDescendantStyleUrls
+    const QStringList &StyleUrls() const         { return m_StyleUrls; }
+
+    // XhtmlDoc::GetAllMediaPathsFromMediaChildren for the
+    // image, video, and audio tags and for all three combined
+    const QStringList &ImagePaths() const        { return m_ImagePaths; }
+    const QStringList &VideoPaths() const        { return m_VideoPaths; }
+    const QStringList &AudioPaths() const        { return m_AudioPaths; }
+    const QStringList &MediaPaths() const        { return m_MediaPaths; }
+
+    // XhtmlDoc::GetLinkedStylesheets
+    const QStringList &LinkedStylesheets() const { return m_LinkedStylesheets; }
+
+    // the raw values of every href, src, poster, data, srcset, and altimg
+    // attribute on any tag and in any namespace, and every url() found in
+    // a style attribute or style tag: everything source updates could
+    // rewrite when a file this one links to is renamed or moved
+    const QStringList &LinkAttributeValues() const { return m_LinkAttributeValues; }
+    const QStringList &AllStyleUrls() const        { return m_AllStyleUrls; }
+
+private:
+
+    QStringList m_IDs;
+    QStringList m_IDAttributes;
+    QStringList m_Hrefs;
+    QStringList m_RelativeAnchorHrefs;
+    QStringList m_Classes;
+    QStringList m_StyleUrls;
+    QStringList m_ImagePaths;
+    QStringList m_VideoPaths;
+    QStringList m_AudioPaths;
+    QStringList m_MediaPaths;
+    QStringList m_LinkedStylesheets;
+    QStringList m_LinkAttributeValues;
+    QStringList m_AllStyleUrls;
+};
+
+#endif // HTMLINDEX_H
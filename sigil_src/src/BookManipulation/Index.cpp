@@ -35,37 +35,64 @@
 #include "BookManipulation/XhtmlDoc.h"
 #include "MiscEditors/IndexEditorModel.h"
 #include "BookManipulation/Index.h"
+#include "BookManipulation/IndexMatcher.h"
 #include "MiscEditors/IndexEntries.h"
+#include "Misc/FutureProgress.h"
 #include "sigil_constants.h"
 
 const QString SIGIL_INDEX_CLASS = "sigil_index_marker";
 const QString SIGIL_INDEX_ID_PREFIX = "sigil_index_id_";
 
+// If no index text, use the pattern
+// If index text is a category then append the pattern
+// Otherwise use the given index text
+static QString IndexText(const QString &pattern, const QString &index_entry)
+{
+    if (index_entry.isEmpty()) {
+        return pattern;
+    } else if (index_entry.endsWith("/")) {
+        return index_entry + pattern;
+    }
+    return index_entry;
+}
+
+
 bool Index::BuildIndex(QList<HTMLResource *> html_resources)
 {
     IndexEntries::instance()->Clear();
+
+    // Compile the Index Editor patterns just once for all files
+    QList<IndexEditorModel::indexEntry *> entries = IndexEditorModel::instance()->GetEntries();
+    IndexMatcher matcher(entries);
+    qDeleteAll(entries);
+
     // Display progress dialog
     QProgressDialog progress(QObject::tr("Creating Index..."), QObject::tr("Cancel"), 0, html_resources.count(), QApplication::activeWindow());
     progress.setMinimumDuration(0);
-    int progress_value = 0;
-    progress.setValue(progress_value);
-    qApp->processEvents();
-    // Must do sequentially in order to keep sections in order
-    foreach(HTMLResource * html_resource, html_resources) {
-        // Set progress value and ensure dialog has time to display when doing extensive updates
-        if (progress.wasCanceled()) {
-            return false;
-        }
+    progress.setValue(0);
+
+    // Files are scanned on a pool of threads but their entries are only
+    // added afterwards, in spine order, to keep sections in order
+    QFuture< QList<IndexHit> > future = QtConcurrent::mapped(html_resources,
+                                                             std::bind(AddIndexIDsOneFile,
+                                                                       std::placeholders::_1, std::cref(matcher)));
+    FutureProgress::Wait(future, progress);
+    if (future.isCanceled()) {
+        return false;
+    }
 
-        progress.setValue(progress_value++);
-        qApp->processEvents();
-        AddIndexIDsOneFile(html_resource);
+    for (int i = 0; i < html_resources.count(); ++i) {
+        QString bookpath = html_resources.at(i)->GetRelativePath();
+        foreach(IndexHit hit, future.resultAt(i)) {
+            IndexEntries::instance()->AddOneEntry(hit.text, bookpath, hit.index_id_value);
+        }
     }
     return true;
 }
 
-void Index::AddIndexIDsOneFile(HTMLResource *html_resource)
+QList<Index::IndexHit> Index::AddIndexIDsOneFile(HTMLResource *html_resource, const IndexMatcher &matcher)
 {
+    QList<IndexHit> hits;
     QWriteLocker locker(&html_resource->GetLock());
     QString source = html_resource->GetText();
     QString version = html_resource->GetEpubVersion();
@@ -116,11 +143,11 @@ void Index::AddIndexIDsOneFile(HTMLResource *html_resource)
         // Use the existing id if there is one, else add one if node contains index item
         attr = gumbo_get_attribute(&node->v.element.attributes, "id");
         if (attr) {
-            CreateIndexEntry(text_node_text, html_resource, index_id_value, is_custom_index_entry, custom_index_value);
+            CreateIndexEntry(text_node_text, matcher, index_id_value, is_custom_index_entry, custom_index_value, hits);
         } else {
             index_id_value = SIGIL_INDEX_ID_PREFIX + QString::number(index_id_number);
 
-            if (CreateIndexEntry(text_node_text, html_resource, index_id_value, is_custom_index_entry, custom_index_value)) {
+            if (CreateIndexEntry(text_node_text, matcher, index_id_value, is_custom_index_entry, custom_index_value, hits)) {
                 GumboElement* element = &node->v.element;
                 gumbo_element_set_attribute(element, "id", index_id_value.toUtf8().constData()); 
                 resource_updated = true;
@@ -132,47 +159,32 @@ void Index::AddIndexIDsOneFile(HTMLResource *html_resource)
     if (resource_updated) {
         html_resource->SetText(gi.getxhtml());
     }
+    return hits;
 }
 
 
-bool Index::CreateIndexEntry(const QString text, HTMLResource *html_resource, QString index_id_value, bool is_custom_index_entry, QString custom_index_value)
+bool Index::CreateIndexEntry(const QString &text, const IndexMatcher &matcher, const QString &index_id_value,
+                             bool is_custom_index_entry, const QString &custom_index_value, QList<IndexHit> &hits)
 {
-    bool created_index = false;
-    QList<IndexEditorModel::indexEntry *> entries;
-
     if (is_custom_index_entry) {
-        IndexEditorModel::indexEntry *custom_entry = new IndexEditorModel::indexEntry();
-        // need to escape text to prevent it being interpreted 
-        // as a QRegularExpression special character
-        custom_entry->pattern = QRegularExpression::escape(text);
-        custom_entry->index_entry = custom_index_value;
-        entries.append(custom_entry);
-    } else {
-        entries = IndexEditorModel::instance()->GetEntries();
-    }
-
-    foreach(IndexEditorModel::indexEntry * entry, entries) {
-        QString index_pattern = entry->pattern;
-        if (index_pattern.isEmpty()) {
-            continue;
+        // the custom entry's pattern is just its own text escaped
+        // so it is always found unless there is no text at all
+        if (text.isEmpty()) {
+            return false;
         }
+        IndexHit hit;
+        hit.text = IndexText(QRegularExpression::escape(text), custom_index_value);
+        hit.index_id_value = index_id_value;
+        hits.append(hit);
+        return true;
+    }
 
-        QRegularExpression index_regex(index_pattern);
-
-        if (text.contains(index_regex)) {
-            created_index = true;
-            QString index_entry = entry->index_entry;
-            if (index_entry.isEmpty()) {
-                // If no index text, use the pattern
-                IndexEntries::instance()->AddOneEntry(index_pattern, html_resource->GetRelativePath(), index_id_value);
-            } else if (entry->index_entry.endsWith("/")) {
-                // If index text is a category then append the pattern
-                IndexEntries::instance()->AddOneEntry(index_entry + index_pattern, html_resource->GetRelativePath(), index_id_value);
-            } else {
-                // Use the given index text
-                IndexEntries::instance()->AddOneEntry(index_entry, html_resource->GetRelativePath(), index_id_value);
-            }
-        }
+    QList<int> found = matcher.Match(text);
+    foreach(int i, found) {
+        IndexHit hit;
+        hit.text = IndexText(matcher.Pattern(i), matcher.IndexEntry(i));
+        hit.index_id_value = index_id_value;
+        hits.append(hit);
     }
-    return created_index;
+    return !found.isEmpty();
 }
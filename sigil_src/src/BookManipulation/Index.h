@@ -25,7 +25,11 @@
 #ifndef INDEX_H
 #define INDEX_H
 
+#include <QList>
+#include <QString>
+
 class HTMLResource;
+class IndexMatcher;
 
 /**
  * Houses the Index process.
@@ -39,9 +43,16 @@ public:
     static bool BuildIndex(QList<HTMLResource *> html_resources);
 
 private:
-    static void AddIndexIDsOneFile(HTMLResource *html_resource);
+    // an index entry found in a file, added to IndexEntries once all files are done
+    struct IndexHit {
+        QString text;
+        QString index_id_value;
+    };
+
+    static QList<IndexHit> AddIndexIDsOneFile(HTMLResource *html_resource, const IndexMatcher &matcher);
 
-    static bool CreateIndexEntry(const QString text, HTMLResource *html_resource, QString index_id_name, bool is_custom_index_entry, QString custom_index_name);
+    static bool CreateIndexEntry(const QString &text, const IndexMatcher &matcher, const QString &index_id_value,
+                                 bool is_custom_index_entry, const QString &custom_index_value, QList<IndexHit> &hits);
 };
 
 #endif // INDEX_H
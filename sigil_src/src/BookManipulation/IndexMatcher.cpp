@@ -0,0 +1,213 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <algorithm>
+#include <utility>
+
+#include "BookManipulation/IndexMatcher.h"
+
+// anything that makes a pattern more than a plain string to find
+static const QString REGEX_SYNTAX_CHARS = "\\^$.|?*+()[]{}";
+
+// capture group references, named groups, recursion, conditional groups,
+// \Q quoting, and leading (*VERB) settings all change meaning once a pattern
+// is placed inside a larger alternation, so those patterns are only ever run alone
+static const QRegularExpression UNCOMBINABLE(
+    "\\\\[0-9gkQ]|\\(\\?(?:P|'|<[A-Za-z_]|R|&|[+-]?[0-9])|\\(\\?\\(|\\(\\*");
+
+
+IndexMatcher::IndexMatcher(const QList<IndexEditorModel::indexEntry *> &entries)
+    : m_Fail(1, 0),
+      m_Output(1),
+      m_OutLink(1, 0),
+      m_HasCombined(false)
+{
+    QStringList combined;
+    foreach(IndexEditorModel::indexEntry * entry, entries) {
+        // an empty pattern never creates an index entry
+        if (entry->pattern.isEmpty()) {
+            continue;
+        }
+        int i = m_Entries.count();
+        m_Entries.append(*entry);
+        if (IsLiteral(entry->pattern)) {
+            AddLiteral(entry->pattern, i);
+            continue;
+        }
+        RegexEntry re;
+        re.entry = i;
+        re.regex = QRegularExpression(entry->pattern);
+        // an invalid pattern never matched anything so it can be left out
+        if (!re.regex.isValid()) {
+            continue;
+        }
+        re.regex.optimize();
+        re.combined = IsCombinable(entry->pattern);
+        if (re.combined) {
+            combined << "(?:" + entry->pattern + ")";
+        }
+        m_Regexes.append(re);
+    }
+    BuildLinks();
+
+    if (!combined.isEmpty()) {
+        m_Combined = QRegularExpression(combined.join("|"));
+        m_HasCombined = m_Combined.isValid();
+        if (m_HasCombined) {
+            m_Combined.optimize();
+        }
+    }
+    // without a usable alternation every regex entry is tried on its own
+    if (!m_HasCombined) {
+        for (int i = 0; i < m_Regexes.count(); i++) {
+            m_Regexes[i].combined = false;
+        }
+    }
+}
+
+
+QList<int> IndexMatcher::Match(const QString &text) const
+{
+    QList<int> found;
+    std::vector<bool> seen(m_Entries.count(), false);
+
+    if (m_Goto.size() > 0) {
+        int state = 0;
+        const QChar *p = text.constData();
+        const QChar *end = p + text.length();
+        for (; p < end; ++p) {
+            state = NextState(state, p->unicode());
+            int s = m_Output[state].empty() ? m_OutLink[state] : state;
+            // once a state's entries are seen so are all of its suffixes' entries
+            for (; (s > 0) && !seen[m_Output[s].front()]; s = m_OutLink[s]) {
+                for (int entry : m_Output[s]) {
+                    seen[entry] = true;
+                    found.append(entry);
+                }
+            }
+        }
+    }
+
+    if (!m_Regexes.isEmpty()) {
+        bool any_combined = m_HasCombined && text.contains(m_Combined);
+        foreach(const RegexEntry &re, m_Regexes) {
+            if (re.combined && !any_combined) {
+                continue;
+            }
+            if (text.contains(re.regex)) {
+                found.append(re.entry);
+            }
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+
+bool IndexMatcher::IsLiteral(const QString &pattern)
+{
+    foreach(QChar c, pattern) {
+        if (REGEX_SYNTAX_CHARS.contains(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool IndexMatcher::IsCombinable(const QString &pattern)
+{
+    return !pattern.contains(UNCOMBINABLE);
+}
+
+
+void IndexMatcher::AddLiteral(const QString &pattern, int entry)
+{
+    int state = 0;
+    foreach(QChar c, pattern) {
+        quint64 key = (quint64(state) << 16) | c.unicode();
+        std::unordered_map<quint64, int>::const_iterator it = m_Goto.find(key);
+        if (it != m_Goto.end()) {
+            state = it->second;
+            continue;
+        }
+        int next = static_cast<int>(m_Fail.size());
+        m_Fail.push_back(0);
+        m_Output.push_back(std::vector<int>());
+        m_OutLink.push_back(0);
+        m_Goto.emplace(key, next);
+        state = next;
+    }
+    m_Output[state].push_back(entry);
+}
+
+
+// a breadth first walk setting each state's failure link to the longest
+// proper suffix of its string that is also a state of the automaton
+void IndexMatcher::BuildLinks()
+{
+    std::vector<std::vector<std::pair<ushort, int> > > children(m_Fail.size());
+    for (std::unordered_map<quint64, int>::const_iterator it = m_Goto.begin(); it != m_Goto.end(); ++it) {
+        children[it->first >> 16].push_back(std::make_pair(ushort(it->first & 0xFFFF), it->second));
+    }
+
+    std::vector<int> queue;
+    queue.push_back(0);
+    for (size_t q = 0; q < queue.size(); q++) {
+        int state = queue[q];
+        for (const std::pair<ushort, int> &child : children[state]) {
+            int fail = 0;
+            if (state != 0) {
+                int f = m_Fail[state];
+                while (true) {
+                    std::unordered_map<quint64, int>::const_iterator it = m_Goto.find((quint64(f) << 16) | child.first);
+                    if (it != m_Goto.end()) {
+                        fail = it->second;
+                        break;
+                    }
+                    if (f == 0) {
+                        break;
+                    }
+                    f = m_Fail[f];
+                }
+            }
+            m_Fail[child.second] = fail;
+            m_OutLink[child.second] = m_Output[fail].empty() ? m_OutLink[fail] : fail;
+            queue.push_back(child.second);
+        }
+    }
+}
+
+
+int IndexMatcher::NextState(int state, ushort ch) const
+{
+    while (true) {
+        std::unordered_map<quint64, int>::const_iterator it = m_Goto.find((quint64(state) << 16) | ch);
+        if (it != m_Goto.end()) {
+            return it->second;
+        }
+        if (state == 0) {
+            return 0;
+        }
+        state = m_Fail[state];
+    }
+}
@@ -0,0 +1,86 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef INDEXMATCHER_H
+#define INDEXMATCHER_H
+
+#include <vector>
+#include <unordered_map>
+#include <QList>
+#include <QString>
+#include <QRegularExpression>
+
+#include "MiscEditors/IndexEditorModel.h"
+
+// The Index Editor entries compiled once for a whole Create Index run.
+//
+// Entries whose pattern uses no regular expression syntax at all are all
+// found together by one Aho-Corasick automaton run over the utf-16 text.
+// The others are each compiled just once, and those that safely can be are
+// also joined into one alternation so a single search rules all of them
+// out for text that matches none of them (the usual case).
+//
+// Once built a matcher is only read, so one may be shared by many threads.
+
+class IndexMatcher
+{
+public:
+
+    IndexMatcher(const QList<IndexEditorModel::indexEntry *> &entries);
+
+    // the entries (in editor order) whose pattern is found in text
+    QList<int> Match(const QString &text) const;
+
+    const QString &Pattern(int i) const    { return m_Entries.at(i).pattern; }
+    const QString &IndexEntry(int i) const { return m_Entries.at(i).index_entry; }
+
+private:
+
+    struct RegexEntry {
+        int entry;
+        QRegularExpression regex;
+        bool combined;
+    };
+
+    static bool IsLiteral(const QString &pattern);
+    static bool IsCombinable(const QString &pattern);
+
+    void AddLiteral(const QString &pattern, int entry);
+    void BuildLinks();
+    int NextState(int state, ushort ch) const;
+
+    QList<IndexEditorModel::indexEntry> m_Entries;
+
+    // the automaton: goto keyed by (state << 16 | utf-16 code unit),
+    // failure links, the entries ending at each state, and the
+    // nearest proper suffix state that has entries ending at it
+    std::unordered_map<quint64, int> m_Goto;
+    std::vector<int> m_Fail;
+    std::vector<std::vector<int> > m_Output;
+    std::vector<int> m_OutLink;
+
+    QList<RegexEntry> m_Regexes;
+    QRegularExpression m_Combined;
+    bool m_HasCombined;
+};
+
+#endif // INDEXMATCHER_H
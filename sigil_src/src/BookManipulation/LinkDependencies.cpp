@@ -0,0 +1,220 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+
+#include <QDir>
+#include <QUrl>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QtConcurrent/QtConcurrent>
+
+#include "BookManipulation/HTMLIndex.h"
+#include "BookManipulation/LinkDependencies.h"
+#include "Misc/Utility.h"
+#include "ResourceObjects/HTMLResource.h"
+#include "ResourceObjects/TextResource.h"
+
+static const QRegularExpression CSS_URL("url\\([\"']?([^\\(\\)\"']*)[\"']?\\)");
+
+
+LinkDependencies::LinkDependencies()
+{
+}
+
+
+QSet<Resource *> LinkDependencies::ResourcesLinkingTo(const QList<Resource *> &resources,
+                                                      const QStringList &bookpaths)
+{
+    QMutexLocker locker(&m_Mutex);
+    QHash<QString, Resource *> by_id;
+    Refresh(resources, by_id);
+
+    QSet<Resource *> linking;
+    foreach(QString bookpath, bookpaths) {
+        QHash<QString, QSet<QString> >::const_iterator it = m_Referrers.constFind(bookpath);
+        if (it == m_Referrers.constEnd()) {
+            continue;
+        }
+        foreach(QString id, it.value()) {
+            Resource *resource = by_id.value(id, NULL);
+            if (resource) {
+                linking.insert(resource);
+            }
+        }
+    }
+    return linking;
+}
+
+
+void LinkDependencies::Refresh(const QList<Resource *> &resources, QHash<QString, Resource *> &by_id)
+{
+    QList<Resource *> stale;
+    foreach(Resource * resource, resources) {
+        TextResource *text_resource = NULL;
+        if ((resource->Type() == Resource::HTMLResourceType) || (resource->Type() == Resource::CSSResourceType)) {
+            text_resource = qobject_cast<TextResource *>(resource);
+        }
+        if (!text_resource) {
+            continue;
+        }
+        QString id = resource->GetIdentifier();
+        by_id.insert(id, resource);
+        QHash<QString, Links>::const_iterator it = m_Links.constFind(id);
+        if ((it == m_Links.constEnd()) ||
+            (it.value().revision != text_resource->GetTextRevision()) ||
+            (it.value().bookpath != resource->GetRelativePath())) {
+            stale.append(resource);
+        }
+    }
+
+    // forget the resources that have left the book
+    foreach(QString id, m_Links.keys()) {
+        if (!by_id.contains(id)) {
+            RemoveEdges(id, m_Links.value(id).targets);
+            m_Links.remove(id);
+        }
+    }
+
+    if (stale.isEmpty()) {
+        return;
+    }
+
+    QFuture<std::pair<QString, Links> > future = QtConcurrent::mapped(stale, FindLinksMapped);
+    const QList<std::pair<QString, Links> > results = future.results();
+    for (const std::pair<QString, Links> &found : results) {
+        QHash<QString, Links>::const_iterator it = m_Links.constFind(found.first);
+        if (it != m_Links.constEnd()) {
+            RemoveEdges(found.first, it.value().targets);
+        }
+        AddEdges(found.first, found.second.targets);
+        m_Links.insert(found.first, found.second);
+    }
+}
+
+
+void LinkDependencies::AddEdges(const QString &id, const QStringList &targets)
+{
+    foreach(QString target, targets) {
+        m_Referrers[target].insert(id);
+    }
+}
+
+
+void LinkDependencies::RemoveEdges(const QString &id, const QStringList &targets)
+{
+    foreach(QString target, targets) {
+        QHash<QString, QSet<QString> >::iterator it = m_Referrers.find(target);
+        if (it == m_Referrers.end()) {
+            continue;
+        }
+        it.value().remove(id);
+        if (it.value().isEmpty()) {
+            m_Referrers.erase(it);
+        }
+    }
+}
+
+
+std::pair<QString, LinkDependencies::Links> LinkDependencies::FindLinksMapped(Resource *resource)
+{
+    Links links;
+    TextResource *text_resource = qobject_cast<TextResource *>(resource);
+    // read the revision before the text so a concurrent change
+    // can only ever cause an extra refresh, never a stale graph
+    links.revision = text_resource->GetTextRevision();
+    links.bookpath = resource->GetRelativePath();
+    // the updates resolve links against this and not GetFolder()
+    QString startdir = QFileInfo(links.bookpath).dir().path();
+    if (resource->Type() == Resource::HTMLResourceType) {
+        links.targets = FindHTMLTargets(resource, startdir);
+    } else {
+        links.targets = FindCSSTargets(text_resource->GetText(), startdir);
+    }
+    links.targets.removeDuplicates();
+    return std::make_pair(resource->GetIdentifier(), links);
+}
+
+
+// attribute values are resolved as LinkRewriter::ResolveAttributePath does
+// and style urls as LinkRewriter::ResolveStyleUrl does
+QStringList LinkDependencies::FindHTMLTargets(Resource *resource, const QString &startdir)
+{
+    HTMLResource *html_resource = qobject_cast<HTMLResource *>(resource);
+    QSharedPointer<const HTMLIndex> index = html_resource->GetHTMLIndex();
+    QStringList targets;
+    foreach(QString value, index->LinkAttributeValues()) {
+        if (value.contains(':')) {
+            continue;
+        }
+        int hashpos = value.indexOf('#');
+        QString attpath = QUrl(hashpos == -1 ? value : value.left(hashpos)).path();
+        if (!attpath.isEmpty()) {
+            targets << Utility::buildBookPath(attpath, startdir);
+        }
+    }
+    foreach(QString url, index->AllStyleUrls()) {
+        if (url.trimmed().isEmpty() || url.contains(':')) {
+            continue;
+        }
+        QString apath = Utility::URLDecodePath(url);
+        if (!apath.isEmpty()) {
+            targets << Utility::buildBookPath(apath, startdir);
+        }
+    }
+    return targets;
+}
+
+
+// PerformCSSUpdates rewrites url() values and, after an @import, quoted
+// strings found inside property values.  Rather than follow its property
+// matching every url() and the text between every pair of neighbouring
+// quote characters is taken, which covers all of those
+QStringList LinkDependencies::FindCSSTargets(const QString &source, const QString &startdir)
+{
+    QStringList candidates;
+    QRegularExpressionMatchIterator mi = CSS_URL.globalMatch(source);
+    while (mi.hasNext()) {
+        candidates << mi.next().captured(1);
+    }
+    int last_quote = -1;
+    for (int i = 0; i < source.length(); i++) {
+        QChar c = source.at(i);
+        if ((c != '"') && (c != '\'')) {
+            continue;
+        }
+        if (last_quote >= 0) {
+            QString quoted = source.mid(last_quote + 1, i - last_quote - 1);
+            if (!quoted.contains('(') && !quoted.contains(')')) {
+                candidates << quoted;
+            }
+        }
+        last_quote = i;
+    }
+
+    QStringList targets;
+    foreach(QString candidate, candidates) {
+        if (candidate.trimmed().isEmpty()) {
+            continue;
+        }
+        targets << Utility::buildBookPath(Utility::URLDecodePath(candidate), startdir);
+    }
+    return targets;
+}
@@ -0,0 +1,86 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+
+#pragma once
+#ifndef LINKDEPENDENCIES_H
+#define LINKDEPENDENCIES_H
+
+#include <utility>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+class Resource;
+
+// The book wide reverse link graph: for every book path, the html and css
+// resources that hold a link to it.
+//
+// The book paths each resource links to are found from its text exactly
+// the way UniversalUpdates resolves them, and are kept against the text
+// revision and book path they were found for, so after the first use only
+// the resources changed since are looked at again.  Every value the
+// updates could rewrite is taken, so the resources found for a path are
+// always a superset of those whose text a rename of that path changes.
+
+class LinkDependencies
+{
+public:
+
+    LinkDependencies();
+
+    /**
+     * Returns those html and css resources from resources holding a link
+     * to at least one of bookpaths.  Resources not in resources are
+     * dropped from the graph.
+     */
+    QSet<Resource *> ResourcesLinkingTo(const QList<Resource *> &resources,
+                                        const QStringList &bookpaths);
+
+private:
+
+    struct Links {
+        int revision;
+        QString bookpath;
+        QStringList targets;
+    };
+
+    void Refresh(const QList<Resource *> &resources, QHash<QString, Resource *> &by_id);
+
+    void AddEdges(const QString &id, const QStringList &targets);
+    void RemoveEdges(const QString &id, const QStringList &targets);
+
+    static std::pair<QString, Links> FindLinksMapped(Resource *resource);
+
+    static QStringList FindHTMLTargets(Resource *resource, const QString &startdir);
+    static QStringList FindCSSTargets(const QString &source, const QString &startdir);
+
+    // keyed on resource identifier so a resource deleted since
+    // can never be confused with a new one at the same address
+    QHash<QString, Links> m_Links;
+    QHash<QString, QSet<QString> > m_Referrers;
+    QMutex m_Mutex;
+};
+
+#endif // LINKDEPENDENCIES_H
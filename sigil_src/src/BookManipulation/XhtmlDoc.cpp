@@ -184,6 +184,12 @@ QList<QString> XhtmlDoc::GetAllDescendantClasses(const QString & source)
 {
     QString version = "any_version";
     GumboInterface gi = GumboInterface(source, version);
+    return GetAllDescendantClasses(gi);
+}
+
+
+QList<QString> XhtmlDoc::GetAllDescendantClasses(GumboInterface &gi)
+{
     QList<GumboNode*> nodes = gi.get_all_nodes_with_attribute(QString("class"));
     QStringList classes;
     foreach(GumboNode * node, nodes) {
@@ -204,6 +210,12 @@ QList<QString> XhtmlDoc::GetAllDescendantStyleUrls(const QString & source)
 {
     QString version = "any_version";
     GumboInterface gi = GumboInterface(source, version);
+    return GetAllDescendantStyleUrls(gi);
+}
+
+
+QList<QString> XhtmlDoc::GetAllDescendantStyleUrls(GumboInterface &gi)
+{
     QList<GumboNode*> nodes = gi.get_all_nodes_with_attribute(QString("style"));
     QStringList styles;
     foreach(GumboNode * node, nodes) {
@@ -225,6 +237,12 @@ QList<QString> XhtmlDoc::GetAllDescendantIDs(const QString & source)
 {
     QString version = "any_version";
     GumboInterface gi = GumboInterface(source, version);
+    return GetAllDescendantIDs(gi);
+}
+
+
+QList<QString> XhtmlDoc::GetAllDescendantIDs(GumboInterface &gi)
+{
     QList<GumboNode*> nodes = gi.get_all_nodes_with_attribute(QString("id"));
     nodes.append(gi.get_all_nodes_with_attribute(QString("name")));
     QStringList IDs;
@@ -251,6 +269,12 @@ QList<QString> XhtmlDoc::GetAllDescendantHrefs(const QString & source)
 {
     QString version = "any_version";
     GumboInterface gi = GumboInterface(source, version);
+    return GetAllDescendantHrefs(gi);
+}
+
+
+QList<QString> XhtmlDoc::GetAllDescendantHrefs(GumboInterface &gi)
+{
     QList<GumboNode*> nodes = gi.get_all_nodes_with_attribute(QString("href"));
     QStringList hrefs;
     foreach(GumboNode * node, nodes) {
@@ -676,6 +700,12 @@ QStringList XhtmlDoc::GetAllMediaPathsFromMediaChildren(const QString & source,
 {
     QString version = "any_version";
     GumboInterface gi = GumboInterface(source, version);
+    return GetAllMediaPathsFromMediaChildren(gi, tags);
+}
+
+
+QStringList XhtmlDoc::GetAllMediaPathsFromMediaChildren(GumboInterface &gi, QList<GumboTag> tags)
+{
     QStringList media_paths;
     QList<GumboNode*> nodes = gi.get_all_nodes_with_tags(tags);
     for (int i = 0; i < nodes.count(); ++i) {
@@ -79,6 +79,12 @@ public:
     static QList<QString> GetAllDescendantIDs(const QString & );
     static QList<QString> GetAllDescendantClasses(const QString & source);
 
+    // versions of the above that share an already parsed document
+    static QList<QString> GetAllDescendantStyleUrls(GumboInterface &gi);
+    static QList<QString> GetAllDescendantHrefs(GumboInterface &gi);
+    static QList<QString> GetAllDescendantIDs(GumboInterface &gi);
+    static QList<QString> GetAllDescendantClasses(GumboInterface &gi);
+
     struct WellFormedError {
         int line;
         int column;
@@ -150,6 +156,8 @@ public:
 
     static QStringList GetAllMediaPathsFromMediaChildren(const QString &source, QList<GumboTag> tags);
 
+    static QStringList GetAllMediaPathsFromMediaChildren(GumboInterface &gi, QList<GumboTag> tags);
+
     static QStringList GetUnmatchedTagsForPosition(int split_position, TagLister& m_TagList);
 
 private:
@@ -32,6 +32,7 @@
 #include "sigil_exception.h"
 #include "BookManipulation/FolderKeeper.h"
 #include "Dialogs/ReportsWidgets/ImageFilesWidget.h"
+#include "Misc/ImageInfoCache.h"
 #include "Misc/NumericItem.h"
 #include "Misc/SettingsStore.h"
 #include "Misc/Utility.h"
@@ -86,6 +87,7 @@ void ImageFilesWidget::SetupTable(int sort_column, Qt::SortOrder sort_order)
     }
 
     m_ItemModel->clear();
+    m_PendingRows.clear();
     QStringList header;
     header.append(tr("Name"));
     header.append(tr("File Size (KB)"));
@@ -111,11 +113,13 @@ void ImageFilesWidget::SetupTable(int sort_column, Qt::SortOrder sort_order)
     foreach(Resource * resource, m_AllImageResources) {
         QString filepath = resource->GetRelativePath();
         QString path = resource->GetFullPath();
-        QImage image;
-        if (resource->Type() == Resource::SVGResourceType) {
-            image = Utility::RenderSvgToImage(path);
-        } else {
-            image.load(path);
+        // until the color and thumbnail are ready only the headers are read,
+        // and ThumbnailReady fills in the rest
+        ImageInfoCache::ImageInfo info;
+        QImage thumbnail;
+        bool ready = ImageInfoCache::instance()->RequestThumbnail(path, m_ThumbnailSize, info, thumbnail);
+        if (!ready) {
+            info = ImageInfoCache::instance()->HeaderInfo(path);
         }
         QList<QStandardItem *> rowItems;
         // Filename
@@ -145,35 +149,43 @@ void ImageFilesWidget::SetupTable(int sort_column, Qt::SortOrder sort_order)
         rowItems << link_item;
         // Width
         NumericItem *width_item = new NumericItem();
-        width_item->setText(QString("%L1").arg(image.width()));
+        width_item->setText(QString("%L1").arg(info.width));
         width_item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
         rowItems << width_item;
         // Height
         NumericItem *height_item = new NumericItem();
-        height_item->setText(QString("%L1").arg(image.height()));
+        height_item->setText(QString("%L1").arg(info.height));
         height_item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
         rowItems << height_item;
         // Pixels
         NumericItem *pixel_item = new NumericItem();
-        pixel_item->setText(QString("%L1").arg(image.width() * image.height()));
+        pixel_item->setText(QString("%L1").arg(info.width * info.height));
         pixel_item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
         rowItems << pixel_item;
         // Color
         QStandardItem *color_item = new QStandardItem();
-        color_item->setText(image.allGray() ? "Grayscale" : "Color");
+        if (ready) {
+            color_item->setText(info.allGray ? "Grayscale" : "Color");
+        }
         rowItems << color_item;
 
         // Thumbnail
-        QPixmap pixmap = QPixmap::fromImage(image);
+        QStandardItem *icon_item = NULL;
         if (m_ThumbnailSize) {
-            if (pixmap.height() > m_ThumbnailSize || pixmap.width() > m_ThumbnailSize) {
-                pixmap = pixmap.scaled(QSize(m_ThumbnailSize, m_ThumbnailSize), Qt::KeepAspectRatio);
+            icon_item = new QStandardItem();
+            if (ready) {
+                icon_item->setData(QVariant(QPixmap::fromImage(thumbnail)), Qt::DecorationRole);
             }
-            QStandardItem *icon_item = new QStandardItem();
-            icon_item->setData(QVariant(pixmap), Qt::DecorationRole);
             rowItems << icon_item;
         }
 
+        if (!ready) {
+            PendingRow pending;
+            pending.color_item = color_item;
+            pending.icon_item = icon_item;
+            m_PendingRows.insert(path, pending);
+        }
+
         for (int i = 0; i < rowItems.count(); i++) {
             rowItems[i]->setEditable(false);
         }
@@ -236,6 +248,19 @@ void ImageFilesWidget::SetupTable(int sort_column, Qt::SortOrder sort_order)
     }
 }
 
+void ImageFilesWidget::ThumbnailReady(const QString &fullfilepath, int thumbnail_size,
+                                      const ImageInfoCache::ImageInfo &info, const QImage &thumbnail)
+{
+    if (thumbnail_size != m_ThumbnailSize || !m_PendingRows.contains(fullfilepath)) {
+        return;
+    }
+    PendingRow pending = m_PendingRows.take(fullfilepath);
+    pending.color_item->setText(info.allGray ? "Grayscale" : "Color");
+    if (pending.icon_item) {
+        pending.icon_item->setData(QVariant(QPixmap::fromImage(thumbnail)), Qt::DecorationRole);
+    }
+}
+
 void ImageFilesWidget::IncreaseThumbnailSize()
 {
     m_ThumbnailSize += THUMBNAIL_SIZE_INCREMENT;
@@ -296,6 +321,13 @@ void ImageFilesWidget::Save()
     QStringList report_info;
     QStringList heading_row;
 
+    // the report is saved complete even while thumbnails are still coming
+    QHash<QString, PendingRow>::const_iterator it;
+    for (it = m_PendingRows.constBegin(); it != m_PendingRows.constEnd(); ++it) {
+        ImageInfoCache::ImageInfo info = ImageInfoCache::instance()->Info(it.key());
+        it.value().color_item->setText(info.allGray ? "Grayscale" : "Color");
+    }
+
     // Get headings
     for (int col = 0; col < ui.fileTree->header()->count(); col++) {
         QStandardItem *item = m_ItemModel->horizontalHeaderItem(col);
@@ -464,4 +496,5 @@ void ImageFilesWidget::connectSignalsSlots()
     connect(m_Delete,     SIGNAL(triggered()), this, SLOT(Delete()));
     connect(ui.buttonBox->button(QDialogButtonBox::Close), SIGNAL(clicked()), this, SIGNAL(CloseDialog()));
     connect(ui.buttonBox->button(QDialogButtonBox::Save), SIGNAL(clicked()), this, SLOT(Save()));
+    connect(ImageInfoCache::instance(), &ImageInfoCache::ThumbnailReady, this, &ImageFilesWidget::ThumbnailReady);
 }
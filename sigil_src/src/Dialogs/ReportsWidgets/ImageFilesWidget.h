@@ -36,6 +36,7 @@
 
 #include "ResourceObjects/Resource.h"
 #include "BookManipulation/Book.h"
+#include "Misc/ImageInfoCache.h"
 #include "Dialogs/ReportsWidgets/ReportsWidget.h"
 
 #include "ui_ReportsImageFilesWidget.h"
@@ -70,12 +71,21 @@ private slots:
     void IncreaseThumbnailSize();
     void DecreaseThumbnailSize();
 
+    void ThumbnailReady(const QString &fullfilepath, int thumbnail_size,
+                        const ImageInfoCache::ImageInfo &info, const QImage &thumbnail);
+
     void Delete();
     void DoubleClick();
 
     void Save();
 
 private:
+    // the items of a row still waiting on ImageInfoCache
+    struct PendingRow {
+        QStandardItem *color_item;
+        QStandardItem *icon_item;
+    };
+
     void ReadSettings();
     void WriteSettings();
 
@@ -92,6 +102,9 @@ private:
 
     int m_ThumbnailSize;
 
+    // by full path
+    QHash<QString, PendingRow> m_PendingRows;
+
     QPointer<QMenu> m_ContextMenu;
 
     QAction *m_Delete;
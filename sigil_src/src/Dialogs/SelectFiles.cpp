@@ -35,6 +35,7 @@
 #include <QWebEngineProfile>
 
 #include "MainUI/MainWindow.h"
+#include "Misc/ImageInfoCache.h"
 #include "Misc/SettingsStore.h"
 #include "Misc/WebProfileMgr.h"
 #include "sigil_constants.h"
@@ -174,6 +175,7 @@ void SelectFiles::SetImages()
     ui.imageTree->reset();
     // ui.imageTree->setTabKeyNavigation(true);
     m_SelectFilesModel->clear();
+    m_PendingThumbnails.clear();
     QStringList header;
     header.append(tr("Files In the Book"));
 
@@ -210,18 +212,15 @@ void SelectFiles::SetImages()
 
         // Do not show thumbnail if file is not an image
         if ((type == Resource::ImageResourceType || type == Resource::SVGResourceType) && m_ThumbnailSize) {
-            QImage image;
-            if (type == Resource::ImageResourceType) {
-                image.load(resource->GetFullPath());
+            // thumbnails not yet cached are filled in by ThumbnailReady
+            ImageInfoCache::ImageInfo info;
+            QImage thumbnail;
+            QStandardItem *icon_item = new QStandardItem();
+            if (ImageInfoCache::instance()->RequestThumbnail(resource->GetFullPath(), m_ThumbnailSize, info, thumbnail)) {
+                icon_item->setData(QVariant(QPixmap::fromImage(thumbnail)), Qt::DecorationRole);
             } else {
-                image = Utility::RenderSvgToImage(resource->GetFullPath());
-            }
-            QPixmap pixmap = QPixmap::fromImage(image);
-            if (pixmap.height() > m_ThumbnailSize || pixmap.width() > m_ThumbnailSize) {
-                pixmap = pixmap.scaled(QSize(m_ThumbnailSize, m_ThumbnailSize), Qt::KeepAspectRatio);
+                m_PendingThumbnails.insert(resource->GetFullPath(), icon_item);
             }
-            QStandardItem *icon_item = new QStandardItem();
-            icon_item->setData(QVariant(pixmap), Qt::DecorationRole);
             icon_item->setEditable(false);
             rowItems << icon_item;
         }
@@ -242,6 +241,19 @@ void SelectFiles::SetImages()
     SelectDefaultImage();
 }
 
+void SelectFiles::ThumbnailReady(const QString &fullfilepath, int thumbnail_size,
+                                 const ImageInfoCache::ImageInfo &info, const QImage &thumbnail)
+{
+    Q_UNUSED(info);
+    if (thumbnail_size != m_ThumbnailSize) {
+        return;
+    }
+    QStandardItem *icon_item = m_PendingThumbnails.take(fullfilepath);
+    if (icon_item) {
+        icon_item->setData(QVariant(QPixmap::fromImage(thumbnail)), Qt::DecorationRole);
+    }
+}
+
 void SelectFiles::SelectDefaultImage()
 {
     QStandardItem *root_item = m_SelectFilesModel->invisibleRootItem();
@@ -343,19 +355,19 @@ void SelectFiles::SetPreviewImage()
     if (resource_type == Resource::ImageResourceType || resource_type == Resource::SVGResourceType) {
 
         // Define detailed information label
-        const QImage img(path);
+        const ImageInfoCache::ImageInfo img = ImageInfoCache::instance()->Info(path);
         const QUrl imgUrl = QUrl::fromLocalFile(path);
-        QString colors_shades = img.isGrayscale() ? tr("shades") : tr("colors");
-        QString grayscale_color = img.isGrayscale() ? tr("Grayscale") : tr("Color");
+        QString colors_shades = img.grayscale ? tr("shades") : tr("colors");
+        QString grayscale_color = img.grayscale ? tr("Grayscale") : tr("Color");
         QString colorsInfo = "";
 
-        if (img.depth() == 32) {
-            colorsInfo = QString(" %1bpp").arg(img.bitPlaneCount());
-        } else if (img.depth() > 0) {
-            colorsInfo = QString(" %1bpp (%2 %3)").arg(img.bitPlaneCount()).arg(img.colorCount()).arg(colors_shades);
+        if (img.depth == 32) {
+            colorsInfo = QString(" %1bpp").arg(img.bitPlaneCount);
+        } else if (img.depth > 0) {
+            colorsInfo = QString(" %1bpp (%2 %3)").arg(img.bitPlaneCount).arg(img.colorCount).arg(colors_shades);
         }
 
-        details = QString("%2x%3px | %4 KB | %5%6").arg(img.width()).arg(img.height())
+        details = QString("%2x%3px | %4 KB | %5%6").arg(img.width).arg(img.height)
                   .arg(fsize).arg(grayscale_color).arg(colorsInfo);
 
         // MainWindow::clearMemoryCaches();
@@ -531,4 +543,5 @@ void SelectFiles::connectSignalsSlots()
     connect(ui.FileTypes,       SIGNAL(itemSelectionChanged()), this, SLOT(SetImages()));
     connect(m_WebView,          SIGNAL(loadFinished(bool)), this, SLOT(PreviewLoadComplete(bool)));
     connect(ui.splitter,    SIGNAL(splitterMoved(int, int)), this, SLOT(SplitterMoved(int, int)));
+    connect(ImageInfoCache::instance(), &ImageInfoCache::ThumbnailReady, this, &SelectFiles::ThumbnailReady);
 }
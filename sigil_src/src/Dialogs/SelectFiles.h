@@ -25,10 +25,13 @@
 #ifndef SELECTFILES_H
 #define SELECTFILES_H
 
+#include <QtCore/QHash>
 #include <QtWidgets/QDialog>
+#include <QtGui/QImage>
 #include <QtGui/QStandardItemModel>
 #include <QStringList>
 
+#include "Misc/ImageInfoCache.h"
 #include "ResourceObjects/Resource.h"
 
 #include "ui_SelectFiles.h"
@@ -75,6 +78,9 @@ private slots:
 
     void SelectDefaultImage();
     void SetPreviewImage();
+
+    void ThumbnailReady(const QString &fullfilepath, int thumbnail_size,
+                        const ImageInfoCache::ImageInfo &info, const QImage &thumbnail);
     
     /**
      * Filters the list of displayed images
@@ -108,6 +114,9 @@ private:
 
     int m_ThumbnailSize;
 
+    // the thumbnail items still waiting on ImageInfoCache, by full path
+    QHash<QString, QStandardItem *> m_PendingThumbnails;
+
     bool m_IsInsertFromDisk;
 
     QListWidgetItem *m_AllItem;
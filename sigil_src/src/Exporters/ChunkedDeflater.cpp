@@ -0,0 +1,159 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+
+#include <string.h>
+
+#include <zlib.h>
+
+#include <QtCore/QFile>
+#include <QtConcurrent/QtConcurrent>
+
+#include "Exporters/ChunkedDeflater.h"
+
+#define BUFF_SIZE 8192
+#define DEFLATE_DICT_SIZE (32 * 1024)
+// The number of chunks deflated at a time ahead of the file being written.
+#define DEFLATE_WINDOW_CHUNKS 256
+
+
+ChunkedDeflater::ChunkedDeflater()
+    : m_FileChunks(1, 0),
+      m_DeflatedStart(0)
+{
+}
+
+
+int ChunkedDeflater::AddFile(const QString &filepath, qint64 size)
+{
+    qint64 offset = 0;
+    do {
+        Job job;
+        job.filepath = filepath;
+        job.offset = offset;
+        job.length = qMin(CHUNK_SIZE, size - offset);
+        job.last = (offset + job.length >= size);
+        m_Jobs.append(job);
+        offset += job.length;
+    } while (offset < size);
+    m_FileChunks.append(m_Jobs.count());
+    return m_FileChunks.count() - 2;
+}
+
+
+ChunkedDeflater::WriteResult ChunkedDeflater::WriteFile(zipFile zfile, int file, uLong &crc)
+{
+    crc = crc32(0L, Z_NULL, 0);
+
+    for (int i = m_FileChunks.at(file); i < m_FileChunks.at(file + 1); i++) {
+        if ((i < m_DeflatedStart) || (i >= m_DeflatedStart + m_Deflated.count())) {
+            m_DeflatedStart = i;
+            m_Deflated = QtConcurrent::blockingMapped<QList<Chunk>>(m_Jobs.mid(i, DEFLATE_WINDOW_CHUNKS), DeflateChunk);
+        }
+        const Chunk &chunk = m_Deflated.at(i - m_DeflatedStart);
+
+        if (!chunk.ok) {
+            return CannotRead;
+        }
+
+        if (zipWriteInFileInZip(zfile, chunk.data.constData(), (unsigned int) chunk.data.size()) != ZIP_OK) {
+            return CannotWrite;
+        }
+        crc = crc32_combine(crc, chunk.crc, chunk.length);
+    }
+    return Written;
+}
+
+
+// Deflates one slice of a file into a raw deflate stream of its own that
+// ends on a byte boundary (or finishes the stream for the last slice), so the
+// slices of a file can simply be written one after the other.  As in pigz
+// each slice is primed with the 32 KB of the file before it, and since the
+// slice boundaries do not depend on the number of threads used neither does
+// the resulting archive.
+ChunkedDeflater::Chunk ChunkedDeflater::DeflateChunk(const Job &job)
+{
+    Chunk chunk;
+    chunk.crc = crc32(0L, Z_NULL, 0);
+    chunk.length = job.length;
+    chunk.ok = false;
+
+    QFile file(job.filepath);
+    qint64 dictlen = qMin(job.offset, (qint64) DEFLATE_DICT_SIZE);
+
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(job.offset - dictlen)) {
+        return chunk;
+    }
+
+    QByteArray input = file.read(dictlen + job.length);
+    file.close();
+
+    if (input.size() != dictlen + job.length) {
+        return chunk;
+    }
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    if (deflateInit2(&zs, LEVEL, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return chunk;
+    }
+
+    if (dictlen > 0) {
+        deflateSetDictionary(&zs, (const Bytef *) input.constData(), (uInt) dictlen);
+    }
+
+    Bytef *next_in = (Bytef *) input.data() + dictlen;
+    chunk.crc = crc32(chunk.crc, next_in, (uInt) job.length);
+    zs.next_in = next_in;
+    zs.avail_in = (uInt) job.length;
+
+    int flush = job.last ? Z_FINISH : Z_SYNC_FLUSH;
+    qsizetype used = 0;
+    chunk.data.resize(deflateBound(&zs, (uLong) job.length) + 16);
+
+    forever {
+        zs.next_out = (Bytef *) chunk.data.data() + used;
+        zs.avail_out = (uInt) (chunk.data.size() - used);
+        int res = deflate(&zs, flush);
+        used = chunk.data.size() - zs.avail_out;
+
+        // a sync flush is done once it leaves output space unused
+        // (or finds nothing left to flush when called again)
+        if ((res == Z_STREAM_END) ||
+            ((flush == Z_SYNC_FLUSH) && (zs.avail_in == 0) &&
+             (((res == Z_OK) && (zs.avail_out > 0)) || (res == Z_BUF_ERROR)))) {
+            break;
+        }
+
+        if ((res != Z_OK) && (res != Z_BUF_ERROR)) {
+            deflateEnd(&zs);
+            return chunk;
+        }
+
+        chunk.data.resize(chunk.data.size() + BUFF_SIZE);
+    }
+
+    deflateEnd(&zs);
+    chunk.data.resize(used);
+    chunk.ok = true;
+    return chunk;
+}
@@ -0,0 +1,95 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+
+#pragma once
+#ifndef CHUNKEDDEFLATER_H
+#define CHUNKEDDEFLATER_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+#include <zip.h>
+
+// Deflates files for a zip archive in independent chunks that are spread
+// over a pool of threads, a window of chunks at a time ahead of the file
+// being written, so only that window is ever held in memory.
+class ChunkedDeflater
+{
+
+public:
+
+    // Files are split into chunks of this size (each primed
+    // with the 32 KB of the file before it)
+    static constexpr qint64 CHUNK_SIZE = 128 * 1024;
+
+    // The compression level the zip entries should be opened with
+    static constexpr int LEVEL = 8;
+
+    enum WriteResult {
+        Written,
+        CannotRead,
+        CannotWrite
+    };
+
+    ChunkedDeflater();
+
+    // Queues size bytes of the file at filepath to be deflated,
+    // returns the number to write that file with
+    int AddFile(const QString &filepath, qint64 size);
+
+    // Writes the deflated data of a queued file into the current entry
+    // of zfile (which must have been opened raw) and returns the crc32
+    // of its uncompressed data in crc; the files are expected to be
+    // written in the order they were added
+    WriteResult WriteFile(zipFile zfile, int file, uLong &crc);
+
+private:
+
+    struct Job {
+        QString filepath;
+        qint64 offset;
+        qint64 length;
+        bool last;
+    };
+
+    struct Chunk {
+        QByteArray data;
+        uLong crc;
+        qint64 length;
+        bool ok;
+    };
+
+    static Chunk DeflateChunk(const Job &job);
+
+    QList<Job> m_Jobs;
+
+    // the first chunk of each file and the chunk after its last
+    QList<int> m_FileChunks;
+
+    QList<Chunk> m_Deflated;
+
+    int m_DeflatedStart;
+
+};
+
+#endif // CHUNKEDDEFLATER_H
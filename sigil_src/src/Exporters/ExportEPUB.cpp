@@ -26,23 +26,38 @@
 
 #include <string>
 #include <string.h>
+#include <stdio.h>
 
+#include <zlib.h>
 #include <zip.h>
+#include <unzip.h>
 #ifdef _WIN32
+#include <windows.h>
 #include <iowin32.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <QtGlobal>
+#if defined(Q_OS_MAC)
+#include <copyfile.h>
 #endif
 
+#include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
 #include <QDirIterator>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
 #include <QTemporaryFile>
 #include <QTextStream>
 
 #include "BookManipulation/CleanSource.h"
 #include "BookManipulation/FolderKeeper.h"
 #include "BookManipulation/XhtmlDoc.h"
+#include "Exporters/ChunkedDeflater.h"
 #include "Exporters/EncryptionXmlWriter.h"
 #include "Exporters/ExportEPUB.h"
 #include "Misc/Utility.h"
@@ -53,6 +68,11 @@
 #include "sigil_constants.h"
 #include "sigil_exception.h"
 
+#ifndef MAX_PATH
+// Set Max length to 256 because that's the max path size on many systems.
+#define MAX_PATH 256
+#endif
+
 #define BUFF_SIZE 8192
 
 const QString BODY_START = "<\\s*body[^>]*>";
@@ -65,6 +85,13 @@ static const QString METAINF_FOLDER_SUFFIX = "/META-INF";
 
 static const char * EPUB_MIME_DATA = "application/epub+zip";
 
+// An entry of the previously saved epub whose compressed data may be reused
+struct ReusableZipEntry {
+    unz64_file_pos pos;
+    uLong crc;
+    ZPOS64_T uncompressed_size;
+};
+
 
 // Constructor;
 // the first parameter is the location where the book
@@ -97,6 +124,9 @@ void ExportEPUB::WriteBook()
     }
     m_Book->GetOPF()->AddModificationDateMeta();
     m_Book->SaveAllResourcesToDisk();
+
+    // Only the files generated just for the epub are written to the temp
+    // folder, everything else is zipped straight from the book folder
     TempFolder tempfolder;
     CreatePublication(tempfolder.GetPath());
 
@@ -104,38 +134,260 @@ void ExportEPUB::WriteBook()
         ObfuscateFonts(tempfolder.GetPath());
     }
 
-    SaveFolderAsEpubToLocation(tempfolder.GetPath(), m_FullFilePath);
+    SaveFolderAsEpubToLocation(m_Book->GetFolderKeeper()->GetFullPathToMainFolder(), tempfolder.GetPath(), m_FullFilePath);
 }
 
-// Creates the publication from the Book
-// (creates XHTML, CSS, OPF, NCX files etc.)
+// Creates the files of the publication that
+// are not kept in the book folder itself
 void ExportEPUB::CreatePublication(const QString &fullfolderpath)
 {
-    Utility::CopyFiles(m_Book->GetFolderKeeper()->GetFullPathToMainFolder(), fullfolderpath);
-
     if (m_Book->HasObfuscatedFonts()) {
+        QDir(fullfolderpath).mkpath(METAINF_FOLDER_SUFFIX.mid(1));
         CreateEncryptionXML(fullfolderpath + METAINF_FOLDER_SUFFIX);
     }
 }
 
-void ExportEPUB::SaveFolderAsEpubToLocation(const QString &fullfolderpath, const QString &fullfilepath)
+
+static unzFile OpenZipForReading(const QString &zippath)
 {
-    QString tempFile = fullfolderpath + "-tmp.epub";
-    QDateTime timeNow = QDateTime::currentDateTime();
-    QString modified_now = timeNow.toString("yyyy-MM-dd hh:mm:ss");
-    zip_fileinfo fileInfo;
 #ifdef Q_OS_WIN32
     zlib_filefunc64_def ffunc;
     fill_win32_filefunc64W(&ffunc);
-    zipFile zfile = zipOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(tempFile)).c_str(), APPEND_STATUS_CREATE, NULL, &ffunc);
+    return unzOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(zippath)).c_str(), &ffunc);
+#else
+    return unzOpen64(QDir::toNativeSeparators(zippath).toUtf8().constData());
+#endif
+}
+
+
+static zipFile OpenZipForWriting(const QString &zippath)
+{
+#ifdef Q_OS_WIN32
+    zlib_filefunc64_def ffunc;
+    fill_win32_filefunc64W(&ffunc);
+    return zipOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(zippath)).c_str(), APPEND_STATUS_CREATE, NULL, &ffunc);
+#else
+    return zipOpen64(QDir::toNativeSeparators(zippath).toUtf8().constData(), APPEND_STATUS_CREATE);
+#endif
+}
+
+
+// Lists the stored or deflated entries of a previously saved epub by name
+// so that the ones whose crc and size match a file being saved can have
+// their compressed data copied over as is.
+static QHash<QString, ReusableZipEntry> IndexReusableEntries(unzFile zfile)
+{
+    QHash<QString, ReusableZipEntry> entries;
+    int res = unzGoToFirstFile(zfile);
+
+    while (res == UNZ_OK) {
+        char file_name[MAX_PATH] = {0};
+        unz_file_info64 file_info;
+        ReusableZipEntry zentry;
+
+        if ((unzGetCurrentFileInfo64(zfile, &file_info, file_name, MAX_PATH, NULL, 0, NULL, 0) != UNZ_OK) ||
+            (unzGetFilePos64(zfile, &zentry.pos) != UNZ_OK)) {
+            break;
+        }
+
+        // skip encrypted entries and any compression method we do not write ourselves
+        bool encrypted = (file_info.flag & 1) != 0;
+        if (!encrypted && ((file_info.compression_method == 0) || (file_info.compression_method == Z_DEFLATED))) {
+            zentry.crc = file_info.crc;
+            zentry.uncompressed_size = file_info.uncompressed_size;
+            entries.insert(QString::fromUtf8(file_name), zentry);
+        }
+        res = unzGoToNextFile(zfile);
+    }
+    return entries;
+}
+
+
+// Closes both archives and removes the partially written epub
+static void AbandonEpub(zipFile zfile, unzFile oldzfile, const QString &zippath)
+{
+    zipClose(zfile, NULL);
+    if (oldzfile != NULL) {
+        unzClose(oldzfile);
+    }
+    QFile::remove(zippath);
+}
+
+
+// A rename replaces the directory entry, not the file, so it would break the
+// link for a symlinked or hard linked epub and hand it our own owner and group.
+// Such epubs keep having their contents copied over instead.  Any extra access
+// control lists are not looked at and are lost on rename as before.
+static bool CanRenameOver(const QFileInfo &destinfo)
+{
+    if (destinfo.isSymLink()) {
+        return false;
+    }
+    if (!destinfo.exists()) {
+        return true;
+    }
+#ifdef Q_OS_WIN32
+    HANDLE handle = CreateFileW(Utility::QStringToStdWString(QDir::toNativeSeparators(destinfo.absoluteFilePath())).c_str(),
+                                0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    bool single_link = GetFileInformationByHandle(handle, &info) && (info.nNumberOfLinks == 1);
+    CloseHandle(handle);
+    return single_link;
+#else
+    struct stat st;
+    if (::stat(QFile::encodeName(destinfo.absoluteFilePath()).constData(), &st) != 0) {
+        return false;
+    }
+    return (st.st_nlink == 1) && (st.st_uid == geteuid()) && (st.st_gid == getegid());
+#endif
+}
+
+
+// Replaces the file at destpath with the one at srcpath in a single step
+static bool RenameOver(const QString &srcpath, const QString &destpath)
+{
+#ifdef Q_OS_WIN32
+    return MoveFileExW(Utility::QStringToStdWString(QDir::toNativeSeparators(srcpath)).c_str(),
+                       Utility::QStringToStdWString(QDir::toNativeSeparators(destpath)).c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
 #else
-    zipFile zfile = zipOpen64(QDir::toNativeSeparators(tempFile).toUtf8().constData(), APPEND_STATUS_CREATE);
+    return ::rename(QFile::encodeName(srcpath).constData(), QFile::encodeName(destpath).constData()) == 0;
 #endif
+}
+
+
+// Overwrite the contents of the real file with the contents from the temp
+// file we saved the data do. We do this instead of simply copying the file
+// because a file copy will lose extended attributes such as labels on OS X.
+static void CopyFileContents(const QString &tempFile, const QString &fullfilepath)
+{
+    QFile temp_epub(tempFile);
+
+    if (!temp_epub.open(QFile::ReadOnly)) {
+        QFile::remove(tempFile);
+        throw(CannotOpenFile(tempFile.toStdString()));
+    }
+
+    QFile real_epub(fullfilepath);
+
+    if (!real_epub.open(QFile::WriteOnly | QFile::Truncate)) {
+        temp_epub.close();
+        QFile::remove(tempFile);
+        throw(CannotWriteFile(fullfilepath.toStdString()));
+    }
+
+    // Copy the contents from the temp file to the real file.
+    char buff[BUFF_SIZE] = {0};
+    qint64 read = 0;
+    qint64 written = 0;
+
+    while ((read = temp_epub.read(buff, BUFF_SIZE)) > 0) {
+        written = real_epub.write(buff, read);
+
+        if (written != read) {
+            temp_epub.close();
+            real_epub.close();
+            QFile::remove(tempFile);
+            throw(CannotCopyFile(fullfilepath.toStdString()));
+        }
+    }
+
+    if (read == -1) {
+        temp_epub.close();
+        real_epub.close();
+        QFile::remove(tempFile);
+        throw(CannotCopyFile(fullfilepath.toStdString()));
+    }
+
+    temp_epub.close();
+    real_epub.close();
+    QFile::remove(tempFile);
+}
+
+
+// An entry about to be written to the new epub
+struct SaveZipEntry {
+    QString relpath;
+    QString filepath;
+    zip_fileinfo fileInfo;
+    qint64 size;
+    bool reuse;
+    ReusableZipEntry old;
+    int deflate_file;
+};
+
+
+// Copies the compressed data of an entry of the old epub as is
+static bool WriteReusedEntry(zipFile zfile, unzFile oldzfile, const SaveZipEntry &sentry, char *buff)
+{
+    unz64_file_pos pos = sentry.old.pos;
+    int method = 0;
+    int level = 0;
+
+    if ((unzGoToFilePos64(oldzfile, &pos) != UNZ_OK) ||
+        (unzOpenCurrentFile2(oldzfile, &method, &level, 1) != UNZ_OK)) {
+        return false;
+    }
+
+    if (zipOpenNewFileInZip4_64(zfile, sentry.relpath.toUtf8().constData(), &sentry.fileInfo, NULL, 0, NULL, 0, NULL, method, level, 1, 15, 8, Z_DEFAULT_STRATEGY, NULL, 0, 0x0b00, 1<<11, 0) != ZIP_OK) {
+        unzCloseCurrentFile(oldzfile);
+        return false;
+    }
+
+    int read = 0;
+
+    while ((read = unzReadCurrentFile(oldzfile, buff, BUFF_SIZE)) > 0) {
+        if (zipWriteInFileInZip(zfile, buff, read) != ZIP_OK) {
+            unzCloseCurrentFile(oldzfile);
+            return false;
+        }
+    }
+
+    unzCloseCurrentFile(oldzfile);
+    return (read == 0) && (zipCloseFileInZipRaw64(zfile, sentry.old.uncompressed_size, sentry.old.crc) == ZIP_OK);
+}
+
+
+void ExportEPUB::SaveFolderAsEpubToLocation(const QString &fullfolderpath, const QString &overlayfolderpath, const QString &fullfilepath)
+{
+    // The new epub is written beside the old one and then renamed over it.
+    // If that is not possible it is written next to the temp folder instead
+    // and its contents copied over the old epub as before.
+    QFileInfo destinfo(fullfilepath);
+    QString tempFile = destinfo.absolutePath() + "/." + destinfo.fileName() +
+                       QString("-%1.tmp").arg(QCoreApplication::applicationPid());
+    bool rename_into_place = CanRenameOver(destinfo);
+    QDateTime timeNow = QDateTime::currentDateTime();
+    QString modified_now = timeNow.toString("yyyy-MM-dd hh:mm:ss");
+    zip_fileinfo fileInfo;
+    zipFile zfile = rename_into_place ? OpenZipForWriting(tempFile) : NULL;
+
+    if (zfile == NULL) {
+        rename_into_place = false;
+        tempFile = overlayfolderpath + "-tmp.epub";
+        zfile = OpenZipForWriting(tempFile);
+    }
 
     if (zfile == NULL) {
         throw (CannotOpenFile(tempFile.toStdString()));
     }
 
+    // Unless disabled, the compressed data of entries unchanged since the
+    // epub was last saved to this path is copied over instead of deflated again
+    unzFile oldzfile = NULL;
+    QHash<QString, ReusableZipEntry> reusable;
+
+    if (!qEnvironmentVariableIsSet("SIGIL_DISABLE_INCREMENTAL_SAVE") && destinfo.isFile()) {
+        oldzfile = OpenZipForReading(fullfilepath);
+        if (oldzfile != NULL) {
+            reusable = IndexReusableEntries(oldzfile);
+        }
+    }
+
     memset(&fileInfo, 0, sizeof(fileInfo));
     fileInfo.tmz_date.tm_sec  = timeNow.time().second();
     fileInfo.tmz_date.tm_min  = timeNow.time().minute();
@@ -146,40 +398,83 @@ void ExportEPUB::SaveFolderAsEpubToLocation(const QString &fullfolderpath, const
 
      // Write the mimetype. This must be uncompressed and the first entry in the archive.
     if (zipOpenNewFileInZip64(zfile, "mimetype", &fileInfo, NULL, 0, NULL, 0, NULL, Z_NO_COMPRESSION, 0, 0) != ZIP_OK) {
-        zipClose(zfile, NULL);
-        QFile::remove(tempFile);
+        AbandonEpub(zfile, oldzfile, tempFile);
         throw(CannotStoreFile("mimetype"));
     }
 
     if (zipWriteInFileInZip(zfile, EPUB_MIME_DATA, (unsigned int)strlen(EPUB_MIME_DATA)) != ZIP_OK) {
         zipCloseFileInZip(zfile);
-        zipClose(zfile, NULL);
-        QFile::remove(tempFile);
+        AbandonEpub(zfile, oldzfile, tempFile);
         throw(CannotStoreFile("mimetype"));
     }
 
     zipCloseFileInZip(zfile);
-    // Write all the files in our directory path to the archive.
-    QDirIterator it(fullfolderpath, QDir::Files | QDir::NoDotAndDotDot | QDir::Readable | QDir::Hidden, QDirIterator::Subdirectories);
 
-    while (it.hasNext()) {
-        it.next();
-        QString relpath = it.filePath().remove(fullfolderpath);
+    // Collect all the files in our directory path, taking any file
+    // that is also in the overlay folder from there instead.
+    QStringList relpaths;
+    QHash<QString, QString> filepaths;
+    foreach(QString folderpath, QStringList() << fullfolderpath << overlayfolderpath) {
+        QDirIterator it(folderpath, QDir::Files | QDir::NoDotAndDotDot | QDir::Readable | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
 
-        while (relpath.startsWith("/")) {
-            relpath = relpath.remove(0, 1);
+        while (it.hasNext()) {
+            it.next();
+            QString relpath = it.filePath().remove(folderpath);
+
+            while (relpath.startsWith("/")) {
+                relpath = relpath.remove(0, 1);
+            }
+
+            // do not double add the mimetype file
+            if (relpath == "mimetype") continue;
+
+            if (!filepaths.contains(relpath)) {
+                relpaths.append(relpath);
+            }
+            filepaths[relpath] = it.filePath();
         }
+    }
 
-        // do not double add the mimetype file
-        if (relpath == "mimetype") continue;
+    // Work out how each file is to be stored and queue the ones
+    // that need compressing to be deflated in chunks.
+    QList<SaveZipEntry> entries;
+    ChunkedDeflater deflater;
 
-        QFileInfo tfile(it.filePath());
+    foreach(QString relpath, relpaths) {
+        SaveZipEntry sentry;
+        sentry.relpath = relpath;
+        sentry.filepath = filepaths.value(relpath);
+        QFileInfo tfile(sentry.filepath);
 
         // Set the proper zip file info if possible
         QString amodified = modified_now;
         size_t afilesize = tfile.size();
-        QString afilecrc = Utility::FileCRC32(it.filePath());
         Resource* resource = m_Book->GetFolderKeeper()->GetResourceByBookPathNoThrow(relpath);
+
+        // Only reread the file if its checksum is not already known
+        // from when it was last written or checksummed.
+        bool own_file = resource && (resource->GetFullPath() == sentry.filepath);
+        QString afilecrc = own_file ? resource->GetWrittenCRC32() : QString();
+        bool crc_from_file = afilecrc.isEmpty();
+        if (crc_from_file) {
+            afilecrc = Utility::FileCRC32(sentry.filepath);
+            if (own_file) {
+                resource->SetWrittenCRC32(afilecrc);
+            }
+        }
+
+        // A remembered checksum is only vouched for by the file's size and
+        // modification time, which a rewrite within one tick can leave alone.
+        // If the file was modified that close to when its checksum was taken
+        // it is checksummed again before old compressed data is copied over
+        // in its place.
+        QHash<QString, ReusableZipEntry>::const_iterator old = reusable.constFind(relpath);
+        if (!crc_from_file && (old != reusable.constEnd()) && (old->uncompressed_size == afilesize) &&
+            resource->WrittenCRC32MayBeStale()) {
+            afilecrc = Utility::FileCRC32(sentry.filepath);
+            resource->SetWrittenCRC32(afilecrc);
+        }
+
         if (resource) {
             QString savedcrc  = resource->GetSavedCRC32();
             QString saveddate = resource->GetSavedDate();
@@ -193,106 +488,101 @@ void ExportEPUB::SaveFolderAsEpubToLocation(const QString &fullfolderpath, const
             }
         }
         QDateTime moddate = QDateTime::fromString(amodified, "yyyy-MM-dd hh:mm:ss");
-        memset(&fileInfo, 0, sizeof(fileInfo));
-        fileInfo.tmz_date.tm_sec  = moddate.time().second();
-        fileInfo.tmz_date.tm_min  = moddate.time().minute();
-        fileInfo.tmz_date.tm_hour = moddate.time().hour();
-        fileInfo.tmz_date.tm_mday = moddate.date().day();
-        fileInfo.tmz_date.tm_mon  = moddate.date().month() - 1;
-        fileInfo.tmz_date.tm_year = moddate.date().year();
+        memset(&sentry.fileInfo, 0, sizeof(sentry.fileInfo));
+        sentry.fileInfo.tmz_date.tm_sec  = moddate.time().second();
+        sentry.fileInfo.tmz_date.tm_min  = moddate.time().minute();
+        sentry.fileInfo.tmz_date.tm_hour = moddate.time().hour();
+        sentry.fileInfo.tmz_date.tm_mday = moddate.date().day();
+        sentry.fileInfo.tmz_date.tm_mon  = moddate.date().month() - 1;
+        sentry.fileInfo.tmz_date.tm_year = moddate.date().year();
+        sentry.size = afilesize;
+        sentry.reuse = false;
+        sentry.deflate_file = -1;
+
+        // An unchanged entry of the old epub is copied over still compressed.
+        bool crc_ok = false;
+        if ((old != reusable.constEnd()) &&
+            (old->uncompressed_size == afilesize) &&
+            (old->crc == afilecrc.toUInt(&crc_ok, 16)) && crc_ok) {
+            unz64_file_pos pos = old->pos;
+            int method = 0;
+            int level = 0;
+            if ((unzGoToFilePos64(oldzfile, &pos) == UNZ_OK) &&
+                (unzOpenCurrentFile2(oldzfile, &method, &level, 1) == UNZ_OK)) {
+                unzCloseCurrentFile(oldzfile);
+                sentry.reuse = true;
+                sentry.old = old.value();
+            }
+        }
 
-        // Add the file entry to the archive.
-        // We should check the uncompressed file size. If it's over >= 0xffffffff the last parameter (zip64) should be 1.
-        if (zipOpenNewFileInZip4_64(zfile, relpath.toUtf8().constData(), &fileInfo, NULL, 0, NULL, 0, NULL, Z_DEFLATED, 8, 0, 15, 8, Z_DEFAULT_STRATEGY, NULL, 0, 0x0b00, 1<<11, 0) != ZIP_OK) {
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            throw(CannotStoreFile(relpath.toStdString()));
+        if (!sentry.reuse) {
+            sentry.deflate_file = deflater.AddFile(sentry.filepath, sentry.size);
         }
+        entries.append(sentry);
+    }
 
-        // the file on disk to write
-        QFile dfile(it.filePath());
+    // Write them all to the archive in order.
+    char buff[BUFF_SIZE] = {0};
 
-        if (!dfile.open(QIODevice::ReadOnly)) {
-            zipCloseFileInZip(zfile);
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            throw(CannotOpenFile(it.fileName().toStdString()));
+    foreach(const SaveZipEntry &sentry, entries) {
+        if (sentry.reuse) {
+            if (!WriteReusedEntry(zfile, oldzfile, sentry, buff)) {
+                AbandonEpub(zfile, oldzfile, tempFile);
+                throw(CannotStoreFile(sentry.relpath.toStdString()));
+            }
+            continue;
         }
 
-        // Write the data from the file on disk into the archive.
-        char buff[BUFF_SIZE] = {0};
-        qint64 read = 0;
-
-        while ((read = dfile.read(buff, BUFF_SIZE)) > 0) {
-            if (zipWriteInFileInZip(zfile, buff, read) != ZIP_OK) {
-                dfile.close();
-                zipCloseFileInZip(zfile);
-                zipClose(zfile, NULL);
-                QFile::remove(tempFile);
-                throw(CannotStoreFile(relpath.toStdString()));
-            }
+        // Add the file entry to the archive.
+        // We should check the uncompressed file size. If it's over >= 0xffffffff the last parameter (zip64) should be 1.
+        if (zipOpenNewFileInZip4_64(zfile, sentry.relpath.toUtf8().constData(), &sentry.fileInfo, NULL, 0, NULL, 0, NULL, Z_DEFLATED, ChunkedDeflater::LEVEL, 1, 15, 8, Z_DEFAULT_STRATEGY, NULL, 0, 0x0b00, 1<<11, 0) != ZIP_OK) {
+            AbandonEpub(zfile, oldzfile, tempFile);
+            throw(CannotStoreFile(sentry.relpath.toStdString()));
         }
 
-        dfile.close();
+        uLong crc = 0;
+        ChunkedDeflater::WriteResult written = deflater.WriteFile(zfile, sentry.deflate_file, crc);
 
         // There was an error reading the file on disk.
-        if (read < 0) {
-            zipCloseFileInZip(zfile);
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            throw(CannotStoreFile(relpath.toStdString()));
+        if (written == ChunkedDeflater::CannotRead) {
+            AbandonEpub(zfile, oldzfile, tempFile);
+            throw(CannotOpenFile(QFileInfo(sentry.filepath).fileName().toStdString()));
         }
 
-        if (zipCloseFileInZip(zfile) != ZIP_OK) {
-            zipClose(zfile, NULL);
-            QFile::remove(tempFile);
-            throw(CannotStoreFile(relpath.toStdString()));
+        if (written != ChunkedDeflater::Written) {
+            AbandonEpub(zfile, oldzfile, tempFile);
+            throw(CannotStoreFile(sentry.relpath.toStdString()));
         }
-    }
-
-    zipClose(zfile, NULL);
-    // Overwrite the contents of the real file with the contents from the temp
-    // file we saved the data do. We do this instead of simply copying the file
-    // because a file copy will lose extended attributes such as labels on OS X.
-    QFile temp_epub(tempFile);
 
-    if (!temp_epub.open(QFile::ReadOnly)) {
-        throw(CannotOpenFile(tempFile.toStdString()));
+        if (zipCloseFileInZipRaw64(zfile, sentry.size, crc) != ZIP_OK) {
+            AbandonEpub(zfile, oldzfile, tempFile);
+            throw(CannotStoreFile(sentry.relpath.toStdString()));
+        }
     }
 
-    QFile real_epub(fullfilepath);
-
-    if (!real_epub.open(QFile::WriteOnly | QFile::Truncate)) {
-        temp_epub.close();
-        throw(CannotWriteFile(fullfilepath.toStdString()));
+    if (oldzfile != NULL) {
+        unzClose(oldzfile);
     }
 
-    // Copy the contents from the temp file to the real file.
-    char buff[BUFF_SIZE] = {0};
-    qint64 read = 0;
-    qint64 written = 0;
-
-    while ((read = temp_epub.read(buff, BUFF_SIZE)) > 0) {
-        written = real_epub.write(buff, read);
-
-        if (written != read) {
-            temp_epub.close();
-            real_epub.close();
-            QFile::remove(tempFile);
-            throw(CannotCopyFile(fullfilepath.toStdString()));
-        }
+    if (zipClose(zfile, NULL) != ZIP_OK) {
+        QFile::remove(tempFile);
+        throw(CannotWriteFile(tempFile.toStdString()));
     }
 
-    if (read == -1) {
-        temp_epub.close();
-        real_epub.close();
-        QFile::remove(tempFile);
-        throw(CannotCopyFile(fullfilepath.toStdString()));
+    if (rename_into_place) {
+        // carry over what a rename would otherwise lose from the old epub
+        if (destinfo.isFile()) {
+            QFile::setPermissions(tempFile, QFile::permissions(fullfilepath));
+#if defined(Q_OS_MAC)
+            copyfile(QFile::encodeName(fullfilepath).constData(), QFile::encodeName(tempFile).constData(), NULL, COPYFILE_XATTR);
+#endif
+        }
+        if (RenameOver(tempFile, fullfilepath)) {
+            return;
+        }
     }
 
-    temp_epub.close();
-    real_epub.close();
-    QFile::remove(tempFile);
+    CopyFileContents(tempFile, fullfilepath);
 }
 
 
@@ -325,7 +615,14 @@ void ExportEPUB::ObfuscateFonts(const QString &fullfolderpath)
             continue;
         }
 
+        // obfuscate a copy of the font, the one in the book folder is left as is
         QString font_path = fullfolderpath + "/" + font_resource->GetRelativePath();
+        QDir().mkpath(QFileInfo(font_path).absolutePath());
+
+        if (!QFile::copy(font_resource->GetFullPath(), font_path)) {
+            std::string msg = font_resource->GetFullPath().toStdString() + ": " + font_path.toStdString();
+            throw(CannotCopyFile(msg));
+        }
 
         if (algorithm == ADOBE_FONT_ALGO_ID) {
             FontObfuscation::ObfuscateFile(font_path, algorithm, uuid_id);
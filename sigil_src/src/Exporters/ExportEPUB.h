@@ -47,21 +47,25 @@ public:
 
 private:
 
-    // Creates the publication from the Book
-    // (creates XHTML, CSS, OPF, NCX files etc.)
+    // Creates the files of the publication that
+    // are not kept in the book folder itself
+    // (currently just the encryption.xml file)
     void virtual CreatePublication(const QString &fullfolderpath);
 
     // Saves the publication in the specified folder
     // to the specified file path as an epub;
-    // the second optional parameter specifies the
-    // mimetype to write to the special "mimetype" file
-    void SaveFolderAsEpubToLocation(const QString &fullfolderpath, const QString &fullfilepath);
+    // files also present in the overlay folder are
+    // taken from there instead, and entries unchanged
+    // since the epub was last saved to that path are
+    // copied over without being compressed again
+    void SaveFolderAsEpubToLocation(const QString &fullfolderpath, const QString &overlayfolderpath, const QString &fullfilepath);
 
     // Creates the publication's encryption.xml file,
     // if there are any fonts to obfuscate
     void CreateEncryptionXML(const QString &fullfolderpath);
 
-    // Obfuscates the fonts marked for obfuscation
+    // Obfuscates copies of the fonts marked for obfuscation
+    // in the specified folder
     void ObfuscateFonts(const QString &fullfolderpath);
 
     ///////////////////////////////
@@ -75,6 +75,8 @@
 #endif
 // This is the same read buffer size used by Java and Perl.
 #define BUFF_SIZE 8192
+// Small archives are not worth spreading over several workers.
+#define MIN_ENTRIES_PER_WORKER 16
 
 const QString DUBLIN_CORE_NS             = "http://purl.org/dc/elements/1.1/";
 static const QString OEBPS_MIMETYPE      = "application/oebps-package+xml";
@@ -409,24 +411,114 @@ void ImportEPUB::ProcessFontFiles(const QList<Resource *> &resources,
     }
 }
 
-void ImportEPUB::ExtractContainer()
+// A file entry of the zip archive to be extracted
+struct ZipExtractEntry {
+    unz64_file_pos pos;
+    QString name;
+    QString bookpath;
+    QString file_path;
+    QString cp437_file_path;
+    std::tuple<size_t, QString, QString> info;
+};
+
+
+static unzFile OpenZipForReading(const QString &zippath)
 {
-    int res = 0;
-    if (!cp437) {
-        cp437 = new QStringDecoder("IBM437");
-    }
 #ifdef Q_OS_WIN32
     zlib_filefunc64_def ffunc;
     fill_win32_filefunc64W(&ffunc);
-    unzFile zfile = unzOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(m_FullFilePath)).c_str(), &ffunc);
+    return unzOpen2_64(Utility::QStringToStdWString(QDir::toNativeSeparators(zippath)).c_str(), &ffunc);
 #else
-    unzFile zfile = unzOpen64(QDir::toNativeSeparators(m_FullFilePath).toUtf8().constData());
+    return unzOpen64(QDir::toNativeSeparators(zippath).toUtf8().constData());
 #endif
+}
+
+
+// Inflates, writes and crc checks the given entries (in order) using
+// a handle to the archive of its own.
+// Returns the index of the first entry that failed or -1 if all succeeded.
+static int ExtractZipEntries(const QString &zippath, const QList<ZipExtractEntry> &entries, const QList<int> &indexes)
+{
+    if (indexes.isEmpty()) return -1;
+
+    unzFile zfile = OpenZipForReading(zippath);
+    if (zfile == NULL) return indexes.first();
+
+    // Buffered reading and writing.
+    QByteArray buffer(BUFF_SIZE, 0);
+    char *buff = buffer.data();
+
+    foreach(int idx, indexes) {
+        const ZipExtractEntry &zentry = entries.at(idx);
+
+        // Open the file entry in the archive for reading.
+        unz64_file_pos pos = zentry.pos;
+        if ((unzGoToFilePos64(zfile, &pos) != UNZ_OK) || (unzOpenCurrentFile(zfile) != UNZ_OK)) {
+            unzClose(zfile);
+            return idx;
+        }
+
+        // Open the file on disk to write the entry in the archive to.
+        QFile entry(zentry.file_path);
+
+        if (!entry.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            unzCloseCurrentFile(zfile);
+            unzClose(zfile);
+            return idx;
+        }
+
+        int read = 0;
+
+        while ((read = unzReadCurrentFile(zfile, buff, BUFF_SIZE)) > 0) {
+            entry.write(buff, read);
+        }
+
+        entry.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner |
+                             QFileDevice::ReadUser  | QFileDevice::WriteUser  |
+                             QFileDevice::ReadOther);
+        entry.close();
+
+        // Read errors are marked by a negative read amount.
+        if (read < 0) {
+            unzCloseCurrentFile(zfile);
+            unzClose(zfile);
+            return idx;
+        }
+
+        // The file was read but the CRC did not match.
+        // We don't check the read file size vs the uncompressed file size
+        // because if they're different there should be a CRC error.
+        if (unzCloseCurrentFile(zfile) == UNZ_CRCERROR) {
+            unzClose(zfile);
+            return idx;
+        }
+    }
+
+    unzClose(zfile);
+    return -1;
+}
+
+
+void ImportEPUB::ExtractContainer()
+{
+    int res = 0;
+    if (!cp437) {
+        cp437 = new QStringDecoder("IBM437");
+    }
+    unzFile zfile = OpenZipForReading(m_FullFilePath);
 
     if (zfile == NULL) {
         throw (EPUBLoadParseError(QString(QObject::tr("Cannot unzip EPUB: %1")).arg(QDir::toNativeSeparators(m_FullFilePath)).toStdString()));
     }
 
+    // The central directory is walked once up front to sanitize every file name,
+    // create the folders, and remember where each file entry lives. The entries
+    // themselves are then inflated, written and crc checked on a pool of workers
+    // that each use their own handle to the archive.
+    QList<ZipExtractEntry> entries;
+    QSet<QString> target_paths;
+    bool has_duplicate_targets = false;
+
     // Note: zip archives can do utf-8 but they do NOT have a standard for Unicode NormalizationForm
     // we will choose to use NFC
     res = unzGoToFirstFile(zfile);
@@ -498,7 +590,6 @@ void ImportEPUB::ExtractContainer()
                 }
 
                 if (evil_or_corrupt_epub) {
-                    unzCloseCurrentFile(zfile);
                     unzClose(zfile);
                     throw (EPUBLoadParseError(QString(QObject::tr("Possible evil or corrupt epub file name: %1")).arg(original_path).toStdString()));
                 }
@@ -510,7 +601,7 @@ void ImportEPUB::ExtractContainer()
                 QString file_path = m_ExtractedFolderPath + "/" + qfile_name;
                 QFileInfo qfile_info(file_path);
 
-                QString bookpath;
+                ZipExtractEntry zentry;
 
                 // Is this entry a directory?
                 if (file_info.uncompressed_size == 0 && qfile_name.endsWith('/')) {
@@ -521,72 +612,78 @@ void ImportEPUB::ExtractContainer()
                     // add it to the list of files found inside the zip
                     if (cp437_file_name.isEmpty()) {
                         m_ZipFilePaths << qfile_name;
-                        bookpath = qfile_name;
+                        zentry.bookpath = qfile_name;
                     } else {
                         m_ZipFilePaths << cp437_file_name;
-                        bookpath = cp437_file_name;
+                        zentry.bookpath = cp437_file_name;
                     }
                 }
 
-                // Open the file entry in the archive for reading.
-                if (unzOpenCurrentFile(zfile) != UNZ_OK) {
-                    unzClose(zfile);
-                    throw (EPUBLoadParseError(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
-                }
-
-                // Open the file on disk to write the entry in the archive to.
-                QFile entry(file_path);
-
-                if (!entry.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-                    unzCloseCurrentFile(zfile);
-                    unzClose(zfile);
-                    throw (EPUBLoadParseError(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
-                }
-
-                // Buffered reading and writing.
-                char buff[BUFF_SIZE] = {0};
-                int read = 0;
-
-                while ((read = unzReadCurrentFile(zfile, buff, BUFF_SIZE)) > 0) {
-                    entry.write(buff, read);
-                }
-
-                entry.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner |
-                                     QFileDevice::ReadUser  | QFileDevice::WriteUser  |
-                                     QFileDevice::ReadOther);
-                entry.close();
-
-                // Read errors are marked by a negative read amount.
-                if (read < 0) {
-                    unzCloseCurrentFile(zfile);
-                    unzClose(zfile);
-                    throw (EPUBLoadParseError(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
-                }
-
-                // The file was read but the CRC did not match.
-                // We don't check the read file size vs the uncompressed file size
-                // because if they're different there should be a CRC error.
-                if (unzCloseCurrentFile(zfile) == UNZ_CRCERROR) {
+                if (unzGetFilePos64(zfile, &zentry.pos) != UNZ_OK) {
                     unzClose(zfile);
                     throw (EPUBLoadParseError(QString(QObject::tr("Cannot extract file: %1")).arg(qfile_name).toStdString()));
                 }
+                zentry.name = qfile_name;
+                zentry.file_path = file_path;
                 if (!cp437_file_name.isEmpty() && cp437_file_name != qfile_name) {
-                    QString cp437_file_path = m_ExtractedFolderPath + "/" + cp437_file_name;
-                    QFile::copy(file_path, cp437_file_path);
+                    zentry.cp437_file_path = m_ExtractedFolderPath + "/" + cp437_file_name;
                 }
-                m_FileInfoFromZip[bookpath] = std::make_tuple(afilesize, afilecrc, modified);
+                zentry.info = std::make_tuple(afilesize, afilecrc, modified);
+
+                // entries that land on the same file (even just on a case insensitive
+                // file system) must be written one after the other in archive order
+                QString target_key = file_path.toLower();
+                if (target_paths.contains(target_key)) has_duplicate_targets = true;
+                target_paths.insert(target_key);
+                entries.append(zentry);
             }
         } while ((res = unzGoToNextFile(zfile)) == UNZ_OK);
     }
 
+    unzClose(zfile);
+
     if (res != UNZ_END_OF_LIST_OF_FILE) {
-        unzClose(zfile);
         throw (EPUBLoadParseError(QString(QObject::tr("Cannot open EPUB: %1")).arg(QDir::toNativeSeparators(m_FullFilePath)).toStdString()));
     }
 
-    unzClose(zfile);
+    // Deal the entries out round robin so that every worker gets a similar
+    // mix of large and small files.
+    int num_workers = qMin(QThread::idealThreadCount(), entries.count() / MIN_ENTRIES_PER_WORKER);
+    if (has_duplicate_targets || (num_workers < 1)) num_workers = 1;
+    QList<QList<int> > chunks;
+    for (int i = 0; i < num_workers; ++i) {
+        chunks.append(QList<int>());
+    }
+    for (int i = 0; i < entries.count(); ++i) {
+        chunks[i % num_workers].append(i);
+    }
+
+    QList<int> failures;
+    if (num_workers == 1) {
+        failures.append(ExtractZipEntries(m_FullFilePath, entries, chunks.at(0)));
+    } else {
+        failures = QtConcurrent::blockingMapped(chunks, std::bind(ExtractZipEntries, m_FullFilePath,
+                                                                  std::cref(entries), std::placeholders::_1));
+    }
+
+    // report the first entry in archive order that could not be extracted
+    int failed = -1;
+    foreach(int failure, failures) {
+        if ((failure != -1) && ((failed == -1) || (failure < failed))) failed = failure;
+    }
+    if (failed != -1) {
+        throw (EPUBLoadParseError(QString(QObject::tr("Cannot extract file: %1")).arg(entries.at(failed).name).toStdString()));
+    }
+
+    foreach(const ZipExtractEntry &zentry, entries) {
+        if (!zentry.cp437_file_path.isEmpty()) {
+            QFile::copy(zentry.file_path, zentry.cp437_file_path);
+        }
+        m_FileInfoFromZip[zentry.bookpath] = zentry.info;
+    }
 }
 
+
 void ImportEPUB::LocateOPF()
 {
     QString fullpath = m_ExtractedFolderPath + "/META-INF/container.xml";
@@ -89,6 +89,7 @@
 #include "MainUI/PreviewWindow.h"
 #include "MainUI/TableOfContents.h"
 #include "MainUI/ValidationResultsView.h"
+#include "Misc/FutureProgress.h"
 #include "Misc/HTMLSpellCheck.h"
 #include "Misc/HTMLSpellCheckML.h"
 #include "Misc/KeyboardShortcutManager.h"
@@ -5501,6 +5502,12 @@ void MainWindow::SetValidationResults(const QList<ValidationResult> &results)
 }
 
 
+static bool IsHTMLResourceWellFormed(HTMLResource *html_resource)
+{
+    return html_resource->IsWellFormed();
+}
+
+
 bool MainWindow::SaveFile(const QString &fullfilepath, bool update_current_filename)
 {
     SettingsStore ss;
@@ -5524,14 +5531,33 @@ bool MainWindow::SaveFile(const QString &fullfilepath, bool update_current_filen
 
         QApplication::setOverrideCursor(Qt::WaitCursor);
 
-        QList <HTMLResource *> broken_resources;
-        bool not_well_formed = false;
+        QList <HTMLResource *> html_resources;
         Q_FOREACH(Resource * r, GetAllHTMLResources()) {
             HTMLResource *t = qobject_cast<HTMLResource *>(r);
             if (t) {
-                if (!XhtmlDoc::IsDataWellFormed(t->GetText())) {
+                html_resources.append(t);
+            }
+        }
+
+        // Check the files on a pool of threads, each one reusing its
+        // last verdict if its text has not changed since
+        QList <HTMLResource *> broken_resources;
+        bool not_well_formed = false;
+        {
+            QProgressDialog progress(tr("Checking files..."), tr("Abort"), 0, html_resources.count(), this);
+            progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
+            QFuture<bool> future = QtConcurrent::mapped(html_resources, IsHTMLResourceWellFormed);
+            FutureProgress::Wait(future, progress);
+            if (future.isCanceled()) {
+                QApplication::restoreOverrideCursor();
+                ShowMessageOnStatusBar(tr("Saving EPUB... cancelled"), 0);
+                return false;
+            }
+            QList<bool> verdicts = future.results();
+            for (int i = 0; i < verdicts.count(); ++i) {
+                if (!verdicts.at(i)) {
                     not_well_formed = true;
-                    broken_resources.append(t);
+                    broken_resources.append(html_resources.at(i));
                 }
             }
         }
@@ -5549,7 +5575,17 @@ bool MainWindow::SaveFile(const QString &fullfilepath, bool update_current_filen
                 }
                 QApplication::setOverrideCursor(Qt::WaitCursor);
                 if (button_pressed == QMessageBox::Yes) {
-                    CleanSource::ReformatAll(broken_resources, CleanSource::Mend);
+                    bool canceled = false;
+                    bool mended = CleanSource::ReformatAll(broken_resources, CleanSource::Mend, &canceled);
+                    if (canceled) {
+                        // any files mended before the abort are unsaved changes
+                        if (mended) {
+                            m_Book->SetModified();
+                        }
+                        QApplication::restoreOverrideCursor();
+                        ShowMessageOnStatusBar(tr("Saving EPUB... cancelled"), 0);
+                        return false;
+                    }
                     not_well_formed = false;
                 }
             }
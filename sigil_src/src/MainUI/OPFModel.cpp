@@ -22,6 +22,7 @@
 
 #include <limits>
 
+#include <QtCore/QSet>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QFileIconProvider>
 #include <QMessageBox>
@@ -50,6 +51,10 @@ OPFModel::OPFModel(QObject *parent)
     QStandardItemModel(parent),
     m_RefreshInProgress(false),
     m_Book(NULL),
+    m_SemanticMapsValid(false),
+    m_SemanticOPFRevision(-1),
+    m_SemanticNav(NULL),
+    m_SemanticNavRevision(-1),
     m_TextFolderItem(new QStandardItem("Text")),
     m_StylesFolderItem(new QStandardItem("Styles")),
     m_ImagesFolderItem(new QStandardItem("Images")),
@@ -87,6 +92,7 @@ OPFModel::OPFModel(QObject *parent)
 void OPFModel::SetBook(QSharedPointer<Book> book)
 {
     m_Book = book;
+    m_SemanticMapsValid = false;
     connect(this, SIGNAL(BookContentModified()), m_Book.data(), SLOT(SetModified()));
     Refresh();
 }
@@ -95,9 +101,7 @@ void OPFModel::SetBook(QSharedPointer<Book> book)
 void OPFModel::Refresh()
 {
     m_RefreshInProgress = true;
-    InitializeModel();
-    SortFilesByFilenames();
-    SortHTMLFilesByReadingOrder();
+    UpdateModel();
     m_RefreshInProgress = false;
 }
 
@@ -307,6 +311,11 @@ void OPFModel::RowsRemovedHandler(const QModelIndex &parent, int start, int end)
 void OPFModel::ItemChangedHandler(QStandardItem *item)
 {
     Q_ASSERT(item);
+
+    // rows relabeled by a refresh are not renames by the user
+    if (m_RefreshInProgress) {
+        return;
+    }
     const QString &identifier = item->data().toString();
 
     if (!identifier.isEmpty()) {
@@ -433,7 +442,7 @@ bool OPFModel:: RenameResourceList(const QList<Resource *> &resources, const QSt
     }
 
     if (update.count() > 0) {
-        UniversalUpdates::PerformUniversalUpdates(true, m_Book->GetFolderKeeper()->GetResourceList(), update);
+        UniversalUpdates::PerformUniversalUpdates(true, m_Book->GetResourcesToUpdate(update), update);
         emit BookContentModified();
     }
 
@@ -522,7 +531,7 @@ bool OPFModel::MoveResourceList(const QList<Resource *> &resources, const QStrin
     }
 
     if (update.count() > 0) {
-        UniversalUpdates::PerformUniversalUpdates(true, m_Book->GetFolderKeeper()->GetResourceList(), update);
+        UniversalUpdates::PerformUniversalUpdates(true, m_Book->GetResourcesToUpdate(update), update);
         emit BookContentModified();
     }
 
@@ -536,36 +545,97 @@ bool OPFModel::MoveResourceList(const QList<Resource *> &resources, const QStrin
     return false;
 }
 
-void OPFModel::InitializeModel()
+// Brings the model in line with the book. Rows are matched to resources
+// by identifier and only those added, removed, or relabeled are touched,
+// so large books refresh quickly and the views keep their state.
+void OPFModel::UpdateModel()
 {
     Q_ASSERT(m_Book);
-    ClearModel();
     QList<Resource *> resources = m_Book->GetFolderKeeper()->GetResourceList();
     QHash <Resource *, int> reading_order_all = m_Book->GetOPF()->GetReadingOrderAll(resources);
-    QString version = m_Book->GetConstOPF()->GetEpubVersion();
-    QHash <QString, QStringList> semantic_type_all;
-    QHash <QString, QString> manifest_properties_all;
+    UpdateSemanticMaps();
     SettingsStore ss;
-    if (version.startsWith('3')) {
-        NavProcessor navproc(m_Book->GetConstOPF()->GetNavResource());
-        semantic_type_all = navproc.GetLandmarkNameForPaths();
-        manifest_properties_all = m_Book->GetOPF()->GetManifestPropertiesForPaths();
-    } else { 
-        semantic_type_all = m_Book->GetOPF()->GetGuideSemanticNameForPaths();
+    bool show_full_path = ss.showFullPathOn();
+
+    QHash<QString, QStandardItem *> existing;
+    for (int i = 0; i < invisibleRootItem()->rowCount(); ++i) {
+        QStandardItem *child = invisibleRootItem()->child(i);
+        if (IsFolderItem(child)) {
+            for (int j = 0; j < child->rowCount(); ++j) {
+                existing.insert(child->child(j)->data().toString(), child->child(j));
+            }
+        } else {
+            existing.insert(child->data().toString(), child);
+        }
     }
 
+    QSet<QStandardItem *> folders_to_sort;
     foreach(Resource * resource, resources) {
-        AlphanumericItem * item;
-        QIcon fileicon = m_Book->GetFolderKeeper()->GetFileIconFromMediaType(resource->GetMediaType());
-        if (ss.showFullPathOn()) {
-            item = new AlphanumericItem(fileicon, resource->GetRelativePath());
-        } else {
-            item = new AlphanumericItem(fileicon, resource->ShortPathName());
+        QStandardItem *folder = GetFolderItem(resource->Type());
+        QStandardItem *item = existing.take(resource->GetIdentifier());
+        if (item) {
+            QStandardItem *parent = item->parent() ? item->parent() : invisibleRootItem();
+            if (parent != folder) {
+                parent->removeRow(item->row());
+                item = NULL;
+            }
         }
-        item->setDropEnabled(false);
-        item->setData(resource->GetIdentifier());
-        QString tooltip = resource->GetRelativePath();
-        QString path = resource->GetRelativePath();
+
+        if (!item) {
+            item = new AlphanumericItem();
+            item->setDropEnabled(false);
+            item->setData(resource->GetIdentifier());
+            if (folder == invisibleRootItem()) {
+                item->setEditable(true);
+            }
+            if (folder != m_TextFolderItem) {
+                item->setDragEnabled(false);
+            }
+            UpdateItem(item, resource, reading_order_all, show_full_path);
+            folder->appendRow(item);
+            folders_to_sort.insert(folder);
+        } else if (UpdateItem(item, resource, reading_order_all, show_full_path)) {
+            folders_to_sort.insert(folder);
+        }
+    }
+
+    // anything left over is no longer in the book
+    foreach(QStandardItem * item, existing) {
+        QStandardItem *parent = item->parent() ? item->parent() : invisibleRootItem();
+        parent->removeRow(item->row());
+    }
+
+    foreach(QStandardItem * folder, folders_to_sort) {
+        if (folder != invisibleRootItem()) {
+            folder->sortChildren(0);
+        }
+    }
+    if (folders_to_sort.contains(m_TextFolderItem)) {
+        SortHTMLFilesByReadingOrder();
+    }
+}
+
+
+bool OPFModel::UpdateItem(QStandardItem *item, Resource *resource,
+                          const QHash<Resource *, int> &reading_order_all, bool show_full_path)
+{
+    bool sort_changed = false;
+    QString text = show_full_path ? resource->GetRelativePath() : resource->ShortPathName();
+    if (item->text() != text) {
+        item->setText(text);
+        sort_changed = true;
+    }
+
+    QString media_type = resource->GetMediaType();
+    if (item->data(MEDIA_TYPE_ROLE).toString() != media_type) {
+        item->setIcon(m_Book->GetFolderKeeper()->GetFileIconFromMediaType(media_type));
+        item->setData(media_type, MEDIA_TYPE_ROLE);
+    }
+
+    QString path = resource->GetRelativePath();
+    QString tooltip = path;
+    if (resource->Type() != Resource::OPFResourceType &&
+        resource->Type() != Resource::NCXResourceType) {
         if (resource->Type() == Resource::FontResourceType) {
             FontResource* font_res = qobject_cast<FontResource *>(resource);
             if (font_res) {
@@ -573,63 +643,103 @@ void OPFModel::InitializeModel()
             }
         }
 
-        if (semantic_type_all.contains(path)) {
-            tooltip += " (" + semantic_type_all[path].join(",") + ")";
+        if (m_SemanticTypes.contains(path)) {
+            tooltip += " (" + m_SemanticTypes[path].join(",") + ")";
         }
-        if (manifest_properties_all.contains(path)) {
-            tooltip += " [" + manifest_properties_all[path] + "]";
+        if (m_ManifestProperties.contains(path)) {
+            tooltip += " [" + m_ManifestProperties[path] + "]";
         }
+    }
+    if (item->toolTip() != tooltip) {
         item->setToolTip(tooltip);
+    }
 
-        if (resource->Type() == Resource::HTMLResourceType) {
-            int reading_order = -1;
-            if (reading_order_all.contains(resource)) {
-                reading_order = reading_order_all[resource];
-            } else {
-                reading_order = NO_READING_ORDER;
-            }
-
+    if (resource->Type() == Resource::HTMLResourceType) {
+        int reading_order = reading_order_all.value(resource, NO_READING_ORDER);
+        if (item->data(READING_ORDER_ROLE).toInt() != reading_order) {
             item->setData(reading_order, READING_ORDER_ROLE);
-            // Remove the extension for alphanumeric sorting
-            QString name;
-            if (ss.showFullPathOn()) {
-                name = resource->GetRelativePath().left(resource->GetRelativePath().lastIndexOf('.'));
-            } else {
-                name = resource->ShortPathName().left(resource->ShortPathName().lastIndexOf('.'));
-            }
+            sort_changed = true;
+        }
+        // Remove the extension for alphanumeric sorting
+        QString name = text.left(text.lastIndexOf('.'));
+        if (item->data(ALPHANUMERIC_ORDER_ROLE).toString() != name) {
             item->setData(name, ALPHANUMERIC_ORDER_ROLE);
-            m_TextFolderItem->appendRow(item);
-        } else if (resource->Type() == Resource::CSSResourceType) {
-            item->setDragEnabled(false);
-            m_StylesFolderItem->appendRow(item);
-        } else if (resource->Type() == Resource::ImageResourceType ||
-                   resource->Type() == Resource::SVGResourceType
-                  ) {
-            item->setDragEnabled(false);
-            m_ImagesFolderItem->appendRow(item);
-        } else if (resource->Type() == Resource::FontResourceType) {
-            item->setDragEnabled(false);
-            m_FontsFolderItem->appendRow(item);
-        } else if (resource->Type() == Resource::AudioResourceType) {
-            item->setDragEnabled(false);
-            m_AudioFolderItem->appendRow(item);
-        } else if (resource->Type() == Resource::VideoResourceType) {
-            item->setDragEnabled(false);
-            m_VideoFolderItem->appendRow(item);
-        } else if (resource->Type() == Resource::PdfResourceType) {
-            item->setDragEnabled(false);
-            m_MiscFolderItem->appendRow(item);
-        } else if (resource->Type() == Resource::OPFResourceType ||
-                   resource->Type() == Resource::NCXResourceType) {
-            item->setEditable(true);
-            item->setDragEnabled(false);
-            item->setToolTip(resource->GetRelativePath());
-            appendRow(item);
-        } else {
-            item->setDragEnabled(false);
-            m_MiscFolderItem->appendRow(item);
         }
     }
+    return sort_changed;
+}
+
+
+// The landmark (or guide) names and manifest properties shown in the
+// tooltips, reworked only when the opf or nav they come from has changed
+void OPFModel::UpdateSemanticMaps()
+{
+    OPFResource *opf = m_Book->GetOPF();
+    HTMLResource *nav = opf->GetNavResource();
+    int opf_revision = opf->GetTextRevision();
+    int nav_revision = nav ? nav->GetTextRevision() : -1;
+    QString opf_path = opf->GetRelativePath();
+    QString nav_path = nav ? nav->GetRelativePath() : QString();
+    QString version = m_Book->GetConstOPF()->GetEpubVersion();
+
+    bool version_changed = !m_SemanticMapsValid || (version != m_SemanticVersion);
+    bool opf_changed = version_changed || (opf_revision != m_SemanticOPFRevision) || (opf_path != m_SemanticOPFPath);
+    bool nav_changed = version_changed || (nav != m_SemanticNav) ||
+                       (nav_revision != m_SemanticNavRevision) || (nav_path != m_SemanticNavPath);
+
+    if (version.startsWith('3')) {
+        if (nav_changed) {
+            NavProcessor navproc(nav);
+            m_SemanticTypes = navproc.GetLandmarkNameForPaths();
+        }
+        if (opf_changed) {
+            m_ManifestProperties = opf->GetManifestPropertiesForPaths();
+        }
+    } else if (opf_changed) {
+        m_SemanticTypes = opf->GetGuideSemanticNameForPaths();
+        m_ManifestProperties.clear();
+    }
+
+    m_SemanticMapsValid = true;
+    m_SemanticVersion = version;
+    m_SemanticOPFRevision = opf_revision;
+    m_SemanticOPFPath = opf_path;
+    m_SemanticNav = nav;
+    m_SemanticNavRevision = nav_revision;
+    m_SemanticNavPath = nav_path;
+}
+
+
+QStandardItem *OPFModel::GetFolderItem(Resource::ResourceType resource_type)
+{
+    if (resource_type == Resource::HTMLResourceType) {
+        return m_TextFolderItem;
+    } else if (resource_type == Resource::CSSResourceType) {
+        return m_StylesFolderItem;
+    } else if (resource_type == Resource::ImageResourceType || resource_type == Resource::SVGResourceType) {
+        return m_ImagesFolderItem;
+    } else if (resource_type == Resource::FontResourceType) {
+        return m_FontsFolderItem;
+    } else if (resource_type == Resource::AudioResourceType) {
+        return m_AudioFolderItem;
+    } else if (resource_type == Resource::VideoResourceType) {
+        return m_VideoFolderItem;
+    } else if (resource_type == Resource::OPFResourceType || resource_type == Resource::NCXResourceType) {
+        return invisibleRootItem();
+    }
+    return m_MiscFolderItem;
+}
+
+
+bool OPFModel::IsFolderItem(QStandardItem const *item) const
+{
+    return item == m_TextFolderItem   ||
+           item == m_StylesFolderItem ||
+           item == m_ImagesFolderItem ||
+           item == m_FontsFolderItem  ||
+           item == m_MiscFolderItem   ||
+           item == m_AudioFolderItem  ||
+           item == m_VideoFolderItem;
 }
 
 
@@ -656,64 +766,6 @@ void OPFModel::UpdateHTMLReadingOrders()
 }
 
 
-void OPFModel::ClearModel()
-{
-    while (m_TextFolderItem->rowCount() != 0) {
-        m_TextFolderItem->removeRow(0);
-    }
-
-    while (m_StylesFolderItem->rowCount() != 0) {
-        m_StylesFolderItem->removeRow(0);
-    }
-
-    while (m_ImagesFolderItem->rowCount() != 0) {
-        m_ImagesFolderItem->removeRow(0);
-    }
-
-    while (m_FontsFolderItem->rowCount() != 0) {
-        m_FontsFolderItem->removeRow(0);
-    }
-
-    while (m_MiscFolderItem->rowCount() != 0) {
-        m_MiscFolderItem->removeRow(0);
-    }
-
-    while (m_AudioFolderItem->rowCount() != 0) {
-        m_AudioFolderItem->removeRow(0);
-    }
-
-    while (m_VideoFolderItem->rowCount() != 0) {
-        m_VideoFolderItem->removeRow(0);
-    }
-
-    int i = 0;
-
-    while (i < invisibleRootItem()->rowCount()) {
-        QStandardItem *child = invisibleRootItem()->child(i, 0);
-
-        if (child != m_TextFolderItem   &&
-            child != m_StylesFolderItem &&
-            child != m_ImagesFolderItem &&
-            child != m_FontsFolderItem  &&
-            child != m_MiscFolderItem   &&
-            child != m_AudioFolderItem  &&
-            child != m_VideoFolderItem) {
-            invisibleRootItem()->removeRow(i);
-        } else {
-            ++i;
-        }
-    }
-}
-
-
-void OPFModel::SortFilesByFilenames()
-{
-    for (int i = 0; i < invisibleRootItem()->rowCount(); ++i) {
-        invisibleRootItem()->child(i)->sortChildren(0);
-    }
-}
-
-
 void OPFModel::SortHTMLFilesByReadingOrder()
 {
     int old_sort_role = sortRole();
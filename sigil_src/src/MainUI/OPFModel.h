@@ -24,13 +24,16 @@
 #ifndef OPFMODEL_H
 #define OPFMODEL_H
 
+#include <QtCore/QHash>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QStringList>
 #include <QtGui/QStandardItemModel>
 
 #include "BookManipulation/Book.h"
 #include "ResourceObjects/Resource.h"
 
 class AlphanumericItem;
+class HTMLResource;
 class QModelIndex;
 class QStandardItem;
 
@@ -67,8 +70,8 @@ public:
     void SetBook(QSharedPointer<Book> book);
 
     /**
-     * Forces the recreation of the model
-     * from the information in the stored book.
+     * Brings the model up to date with
+     * the information in the stored book.
      */
     void Refresh();
 
@@ -209,21 +212,37 @@ private slots:
 private:
 
     /**
-     * Initializes an empty model with data. It is filled
-     * using information from the stored book.
+     * Updates the model to match the stored book, adding,
+     * removing, and relabeling only the rows that differ.
      */
-    void InitializeModel();
+    void UpdateModel();
 
     /**
-     * Updates the reading orders of the HTMLResources
-     * with their order in the model.
+     * Sets the text, icon, tooltip, and sort data of a resource's item.
+     *
+     * @return \c true if the item's place in its folder may have changed.
      */
-    void UpdateHTMLReadingOrders();
+    bool UpdateItem(QStandardItem *item, Resource *resource,
+                    const QHash<Resource *, int> &reading_order_all, bool show_full_path);
+
+    /**
+     * Recomputes the semantic and manifest properties maps
+     * if the OPF or nav they are taken from has changed.
+     */
+    void UpdateSemanticMaps();
+
+    /**
+     * The folder item (or the root item) a resource type is listed under.
+     */
+    QStandardItem *GetFolderItem(Resource::ResourceType resource_type);
+
+    bool IsFolderItem(QStandardItem const *item) const;
 
     /**
-     * Sorts \em all files by their filenames, alphabetically.
+     * Updates the reading orders of the HTMLResources
+     * with their order in the model.
      */
-    void SortFilesByFilenames();
+    void UpdateHTMLReadingOrders();
 
     /**
      * Sorts the HTML files by their reading orders.
@@ -235,11 +254,6 @@ private:
      */
     void SortHTMLFilesByAlphanumeric(QList <QModelIndex> index_list);
 
-    /**
-     * Removes all data from the model.
-     */
-    void ClearModel();
-
     /**
      * Determines if a new filename is valid. If it is not,
      * an error dialog is presented to the user informing
@@ -280,6 +294,20 @@ private:
      */
     QSharedPointer<Book> m_Book;
 
+    /**
+     * The landmark or guide names and the manifest properties
+     * by book path, and what they were computed from.
+     */
+    QHash<QString, QStringList> m_SemanticTypes;
+    QHash<QString, QString> m_ManifestProperties;
+    bool m_SemanticMapsValid;
+    QString m_SemanticVersion;
+    int m_SemanticOPFRevision;
+    QString m_SemanticOPFPath;
+    HTMLResource *m_SemanticNav;
+    int m_SemanticNavRevision;
+    QString m_SemanticNavPath;
+
     QStandardItem *m_TextFolderItem;   /**< The Text folder item. */
     QStandardItem *m_StylesFolderItem; /**< The Styles folder item. */
     QStandardItem *m_ImagesFolderItem; /**< The Images folder item. */
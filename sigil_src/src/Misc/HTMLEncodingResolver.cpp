@@ -21,6 +21,7 @@
 **
 *************************************************************************/
 
+#include <cstring>
 #include <string>
 
 #include <QFile>
@@ -39,6 +40,93 @@ const QString STANDALONE_ATTRIBUTE = "standalone\\s*=\\s*(?:\"|')([^\"']+)(?:\"|
 const QString VERSION_ATTRIBUTE    = "<\\?xml[^>]*version\\s*=\\s*(?:\"|')([^\"']+)(?:\"|')[^>]*>";
 
 
+// true if any of the eight bytes is not printable ascii (0x20 to 0x7E)
+static inline bool HasNonPrintableAscii(quint64 w)
+{
+    const quint64 ONES  = Q_UINT64_C(0x0101010101010101);
+    const quint64 HIGHS = Q_UINT64_C(0x8080808080808080);
+    quint64 below_space = (w - ONES * 0x20) & ~w;
+    quint64 x = w ^ (ONES * 0x7F);
+    quint64 is_del = (x - ONES) & ~x;
+    return ((w | below_space | is_del) & HIGHS) != 0;
+}
+
+
+// Walks the bytes as the Perl pattern at
+//   http://www.w3.org/International/questions/qa-forms-utf-8
+// does, returning -1 if they do not match it.  Otherwise the text is
+// decoded into out as utf-16, with CRLF and lone CR line endings made LF,
+// and the number of code units written is returned.  beyond_latin is set
+// if any character at or past U+0300 (where combining marks begin) is seen.
+static qsizetype ScanUtf8(const unsigned char *bytes, qsizetype len, char16_t *out, bool &beyond_latin)
+{
+    qsizetype i = 0;
+    qsizetype n = 0;
+    while (i < len) {
+        // printable ascii eight bytes at a time
+        while (i + 8 <= len) {
+            quint64 w;
+            memcpy(&w, bytes + i, sizeof(w));
+            if (HasNonPrintableAscii(w)) {
+                break;
+            }
+            for (int k = 0; k < 8; k++) {
+                out[n++] = bytes[i + k];
+            }
+            i += 8;
+        }
+        if (i >= len) {
+            break;
+        }
+
+        unsigned char b0 = bytes[i];
+        unsigned char b1 = (i + 1 < len) ? bytes[i + 1] : 0;
+        unsigned char b2 = (i + 2 < len) ? bytes[i + 2] : 0;
+        unsigned char b3 = (i + 3 < len) ? bytes[i + 3] : 0;
+        char32_t cp;
+        if ((0x20 <= b0 && b0 <= 0x7E) || b0 == 0x09 || b0 == 0x0A) {
+            cp = b0;
+            i += 1;
+        } else if (b0 == 0x0D) {
+            // CRLF and lone CR both become LF
+            cp = 0x0A;
+            i += (b1 == 0x0A) ? 2 : 1;
+        } else if ((0xC2 <= b0 && b0 <= 0xDF) && (0x80 <= b1 && b1 <= 0xBF)) {
+            cp = ((b0 & 0x1F) << 6) | (b1 & 0x3F);
+            i += 2;
+        } else if (((b0 == 0xE0) && (0xA0 <= b1 && b1 <= 0xBF)) ||
+                   (((0xE1 <= b0 && b0 <= 0xEC) || b0 == 0xEE || b0 == 0xEF) && (0x80 <= b1 && b1 <= 0xBF)) ||
+                   ((b0 == 0xED) && (0x80 <= b1 && b1 <= 0x9F))) {
+            if (!(0x80 <= b2 && b2 <= 0xBF)) {
+                return -1;
+            }
+            cp = ((b0 & 0x0F) << 12) | ((b1 & 0x3F) << 6) | (b2 & 0x3F);
+            i += 3;
+        } else if (((b0 == 0xF0) && (0x90 <= b1 && b1 <= 0xBF)) ||
+                   ((0xF1 <= b0 && b0 <= 0xF3) && (0x80 <= b1 && b1 <= 0xBF)) ||
+                   ((b0 == 0xF4) && (0x80 <= b1 && b1 <= 0x8F))) {
+            if (!(0x80 <= b2 && b2 <= 0xBF) || !(0x80 <= b3 && b3 <= 0xBF)) {
+                return -1;
+            }
+            cp = ((b0 & 0x07) << 18) | ((b1 & 0x3F) << 12) | ((b2 & 0x3F) << 6) | (b3 & 0x3F);
+            i += 4;
+        } else {
+            return -1;
+        }
+        if (cp >= 0x300) {
+            beyond_latin = true;
+        }
+        if (cp >= 0x10000) {
+            out[n++] = char16_t(0xD800 + ((cp - 0x10000) >> 10));
+            out[n++] = char16_t(0xDC00 + ((cp - 0x10000) & 0x3FF));
+        } else {
+            out[n++] = char16_t(cp);
+        }
+    }
+    return n;
+}
+
+
 // Accepts a full path to an HTML file.
 // Reads the file, detects the encoding
 // and returns the text converted to Unicode.
@@ -54,15 +142,33 @@ QString HTMLEncodingResolver::ReadHTMLFile(const QString &fullfilepath)
 
     QByteArray data = file.readAll();
 
-    return Utility::ConvertLineEndingsAndNormalize(GetDecoderForHTML(data).decode(data));
+    // Text that is declared utf-8, or declares nothing at all but is
+    // valid utf-8, is validated, decoded and has its line endings
+    // converted in a single pass (which is nearly every epub file)
+    QStringDecoder decoder = GetDeclaredDecoderForHTML(data);
+    if (!decoder.isValid() || (qstrcmp(decoder.name(), "UTF-8") == 0)) {
+        QString text;
+        bool beyond_latin = false;
+        if (DecodeUtf8(data, text, beyond_latin)) {
+            // nothing before U+0300 can ever change under NFC
+            return beyond_latin ? Utility::UseNFC(text) : text;
+        }
+    }
+    if (!decoder.isValid()) {
+        // Finally, let Qt guess
+        decoder = QStringDecoder::decoderForHtml(data);
+    }
+
+    return Utility::ConvertLineEndingsAndNormalize(decoder.decode(data));
 }
 
 
-// Accepts an HTML stream and tries to determine its encoding;
-// if no encoding is detected, the default codec for this locale is returned.
+// Accepts an HTML stream and tries to determine its encoding from a BOM,
+// the byte pattern of utf-16, or an encoding or charset named in the file;
+// if none of those gives an encoding an invalid decoder is returned.
 // We use this function because Qt's QTextCodec::codecForHtml() function
 // leaves a *lot* to be desired.
-QStringDecoder HTMLEncodingResolver::GetDecoderForHTML(const QByteArray &raw_text)
+QStringDecoder HTMLEncodingResolver::GetDeclaredDecoderForHTML(const QByteArray &raw_text)
 {
     unsigned char c1;
     unsigned char c2;
@@ -124,92 +230,32 @@ QStringDecoder HTMLEncodingResolver::GetDecoderForHTML(const QByteArray &raw_tex
         }
     }
 
-    // See if all characters within this document are utf-8.
-    if (IsValidUtf8(raw_text)) {
-        return QStringDecoder("UTF-8");
-    }
-
-    // Finally, let Qt guess
-    return QStringDecoder::decoderForHtml(raw_text);
+    return QStringDecoder();
 }
 
 
-// This function goes through the entire byte array
-// and tries to see whether this is a valid UTF-8 sequence.
-// If it's valid, this is probably a UTF-8 string.
-bool HTMLEncodingResolver::IsValidUtf8(const QByteArray &string)
+// Decodes raw_text into text if it is valid utf-8, skipping any
+// initial BOM just as QStringDecoder does, and converting its line
+// endings as Utility::ConvertLineEndingsAndNormalize does.
+bool HTMLEncodingResolver::DecodeUtf8(const QByteArray &raw_text, QString &text, bool &beyond_latin)
 {
-    // This is an implementation of the Perl code written here:
-    //   http://www.w3.org/International/questions/qa-forms-utf-8
-    //
-    // Basically, UTF-8 has a very specific byte-pattern. This function
-    // checks if the sent byte-sequence conforms to this pattern.
-    // If it does, chances are *very* high that this is UTF-8.
-    //
-    // This function is written to be fast, not pretty.
-    if (string.isNull()) {
-        return false;
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(raw_text.constData());
+    qsizetype len = raw_text.size();
+    if ((len >= 3) && (bytes[0] == 0xEF) && (bytes[1] == 0xBB) && (bytes[2] == 0xBF)) {
+        bytes += 3;
+        len -= 3;
     }
-
-    int index = 0;
-
-    while (index < string.size()) {
-        QByteArray dword = string.mid(index, 4);
-
-        if (dword.size() < 4) {
-            dword = dword.leftJustified(4, '\0');
-        }
-
-        const unsigned char *bytes = (const unsigned char *) dword.constData();
-
-        // ASCII
-        if (bytes[0] == 0x09 ||
-            bytes[0] == 0x0A ||
-            bytes[0] == 0x0D ||
-            (0x20 <= bytes[0] && bytes[0] <= 0x7E)
-           ) {
-            index += 1;
-        }
-        // non-overlong 2-byte
-        else if ((0xC2 <= bytes[0] && bytes[0] <= 0xDF) &&
-                 (0x80 <= bytes[1] && bytes[1] <= 0xBF)
-                ) {
-            index += 2;
-        } else if ((bytes[0] == 0xE0                         &&              // excluding overlongs
-                    (0xA0 <= bytes[1] && bytes[1] <= 0xBF) &&
-                    (0x80 <= bytes[2] && bytes[2] <= 0xBF)) ||
-                   (((0xE1 <= bytes[0] && bytes[0] <= 0xEC) ||               // straight 3-byte
-                     bytes[0] == 0xEE                         ||
-                     bytes[0] == 0xEF) &&
-                    (0x80 <= bytes[1] && bytes[1] <= 0xBF)   &&
-                    (0x80 <= bytes[2] && bytes[2] <= 0xBF)) ||
-                   (bytes[0] == 0xED                         &&              // excluding surrogates
-                    (0x80 <= bytes[1] && bytes[1] <= 0x9F) &&
-                    (0x80 <= bytes[2] && bytes[2] <= 0xBF))
-                  ) {
-            index += 3;
-        } else if ((bytes[0] == 0xF0                         &&              // planes 1-3
-                    (0x90 <= bytes[1] && bytes[1] <= 0xBF) &&
-                    (0x80 <= bytes[2] && bytes[2] <= 0xBF) &&
-                    (0x80 <= bytes[3] && bytes[3] <= 0xBF)) ||
-                   ((0xF1 <= bytes[0] && bytes[0] <= 0xF3) &&              // planes 4-15
-                    (0x80 <= bytes[1] && bytes[1] <= 0xBF) &&
-                    (0x80 <= bytes[2] && bytes[2] <= 0xBF) &&
-                    (0x80 <= bytes[3] && bytes[3] <= 0xBF)) ||
-                   (bytes[0] == 0xF4                         &&            // plane 16
-                    (0x80 <= bytes[1] && bytes[1] <= 0x8F) &&
-                    (0x80 <= bytes[2] && bytes[2] <= 0xBF) &&
-                    (0x80 <= bytes[3] && bytes[3] <= 0xBF))
-                  ) {
-            index += 4;
-        } else {
-            return false;
-        }
+    // never more utf-16 code units than utf-8 bytes
+    text = QString(len, Qt::Uninitialized);
+    qsizetype n = ScanUtf8(bytes, len, reinterpret_cast<char16_t *>(text.data()), beyond_latin);
+    if (n < 0) {
+        return false;
     }
-
+    text.truncate(n);
     return true;
 }
 
+
 QByteArray HTMLEncodingResolver::FixupCodePageMapping(const QByteArray& ba)
 {
   if (ba == "cp1250" || ba == "CP1250" || ba == "cp-1250" || ba == "CP-1250") return QByteArray("windows-1250");
@@ -40,16 +40,16 @@ public:
 
 private:
 
-    // Accepts an HTML stream and tries to determine its encoding;
-    // if no encoding is detected, the default codec for this locale is returned.
+    // Accepts an HTML stream and tries to determine its encoding from
+    // a BOM or from what the file itself declares; if none is found
+    // an invalid decoder is returned.
     // We use this function because Qt's QTextCodec::codecForHtml() function
     // leaves a *lot* to be desired.
-    static QStringDecoder GetDecoderForHTML(const QByteArray &raw_text);
+    static QStringDecoder GetDeclaredDecoderForHTML(const QByteArray &raw_text);
 
-    // This function goes through the entire byte array
-    // and tries to see whether this is a valid UTF-8 sequence.
-    // If it's valid, this is probably a UTF-8 string.
-    static bool IsValidUtf8(const QByteArray &string);
+    // Validates, decodes, and converts the line endings of utf-8 text
+    // in one pass, returning false if it is not valid utf-8.
+    static bool DecodeUtf8(const QByteArray &raw_text, QString &text, bool &beyond_latin);
 
     static QByteArray FixupCodePageMapping(const QByteArray& ba);
 };
@@ -0,0 +1,384 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStringList>
+#include <QtConcurrent/QtConcurrent>
+#include <QtGui/QImageReader>
+#include <QtGui/QImageWriter>
+#include <QtSvg/QSvgRenderer>
+#include <QDebug>
+
+#include "sigil_exception.h"
+#include "Misc/ImageInfoCache.h"
+#include "Misc/Utility.h"
+
+#define DBG if(0)
+
+static const bool USE_THUMBNAIL_DISK_CACHE = !qEnvironmentVariableIsSet("SIGIL_DISABLE_THUMBNAIL_CACHE");
+
+static const QString THUMBNAIL_FOLDER = "thumbnails";
+static const QString INFO_TEXT_KEY = "SigilImageInfo";
+
+// images are decoded at no more than this size square to tell
+// whether they are grayscale when no larger thumbnail is wanted
+static const int ANALYSIS_SIZE = 256;
+
+// in KB, thumbnails kept in memory
+static const int MAX_THUMBNAIL_COST = 64 * 1024;
+
+// in days, thumbnails on disk are remade when older than this
+static const int MAX_THUMBNAIL_AGE = 90;
+
+ImageInfoCache *ImageInfoCache::instance()
+{
+    // constructed just once even if first asked for on several threads
+    static ImageInfoCache *cache = new ImageInfoCache();
+    return cache;
+}
+
+
+ImageInfoCache::ImageInfoCache()
+    : m_CacheDir(Utility::DefinePrefsDir() + "/" + THUMBNAIL_FOLDER),
+      m_Thumbnails(MAX_THUMBNAIL_COST)
+{
+    // ThumbnailReady is always emitted from the gui thread's event loop
+    if (QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+    }
+    if (USE_THUMBNAIL_DISK_CACHE) {
+        QDir().mkpath(m_CacheDir);
+        QtConcurrent::run(&m_Pool, [this]() { PruneDiskCache(); });
+    }
+}
+
+
+ImageInfoCache::ImageInfo ImageInfoCache::HeaderInfo(const QString &fullfilepath)
+{
+    ImageInfo info;
+    QImage thumbnail;
+    QString key = KnownFileKey(fullfilepath);
+    if (!key.isEmpty() && CachedEntry(key, 0, info, thumbnail)) {
+        return info;
+    }
+
+    if (QFileInfo(fullfilepath).suffix().toLower() == "svg") {
+        try {
+            QSvgRenderer renderer;
+            renderer.load(Utility::FixupSvgForRendering(Utility::ReadUnicodeTextFile(fullfilepath)).toUtf8());
+            info.width = renderer.defaultSize().width();
+            info.height = renderer.defaultSize().height();
+            // svgs are always rendered into an argb32 image
+            info.depth = 32;
+            info.bitPlaneCount = 32;
+        } catch (CannotOpenFile &) {
+        }
+        return info;
+    }
+
+    QImageReader reader(fullfilepath);
+    QSize size = reader.size();
+    if (size.isValid()) {
+        info.width = size.width();
+        info.height = size.height();
+    }
+    QImage::Format format = reader.imageFormat();
+    if (format != QImage::Format_Invalid) {
+        QImage pixel(1, 1, format);
+        info.depth = pixel.depth();
+        info.bitPlaneCount = pixel.bitPlaneCount();
+    }
+    return info;
+}
+
+
+ImageInfoCache::ImageInfo ImageInfoCache::Info(const QString &fullfilepath)
+{
+    ImageInfo info;
+    QImage thumbnail;
+    Load(fullfilepath, 0, info, thumbnail);
+    return info;
+}
+
+
+bool ImageInfoCache::RequestThumbnail(const QString &fullfilepath, int thumbnail_size,
+                                      ImageInfo &info, QImage &thumbnail)
+{
+    QString key = KnownFileKey(fullfilepath);
+    if (!key.isEmpty() && CachedEntry(key, thumbnail_size, info, thumbnail)) {
+        return true;
+    }
+
+    QString pending = fullfilepath + QChar(0) + QString::number(thumbnail_size);
+    {
+        QMutexLocker locker(&m_Mutex);
+        if (m_Pending.contains(pending)) {
+            return false;
+        }
+        m_Pending.insert(pending);
+    }
+    QtConcurrent::run(&m_Pool, [this, fullfilepath, thumbnail_size, pending]() {
+        ImageInfo info;
+        QImage thumbnail;
+        Load(fullfilepath, thumbnail_size, info, thumbnail);
+        {
+            QMutexLocker locker(&m_Mutex);
+            m_Pending.remove(pending);
+        }
+        QMetaObject::invokeMethod(this, [this, fullfilepath, thumbnail_size, info, thumbnail]() {
+            emit ThumbnailReady(fullfilepath, thumbnail_size, info, thumbnail);
+        }, Qt::QueuedConnection);
+    });
+    return false;
+}
+
+
+QString ImageInfoCache::KnownFileKey(const QString &fullfilepath)
+{
+    QFileInfo fileinfo(fullfilepath);
+    const QDateTime lastModifiedDate = fileinfo.lastModified();
+    qint64 modified = lastModifiedDate.isValid() ? lastModifiedDate.toMSecsSinceEpoch() : 0;
+    QMutexLocker locker(&m_Mutex);
+    QHash<QString, FileStamp>::const_iterator it = m_Stamps.constFind(fullfilepath);
+    if ((it == m_Stamps.constEnd()) || (it->modified != modified) || (it->bytes != fileinfo.size())) {
+        return QString();
+    }
+    return it->key;
+}
+
+
+QString ImageInfoCache::FileKey(const QString &fullfilepath)
+{
+    QString key = KnownFileKey(fullfilepath);
+    if (!key.isEmpty()) {
+        return key;
+    }
+
+    // stat before checksumming so a change made meanwhile is caught next time
+    QFileInfo fileinfo(fullfilepath);
+    const QDateTime lastModifiedDate = fileinfo.lastModified();
+    FileStamp stamp;
+    stamp.modified = lastModifiedDate.isValid() ? lastModifiedDate.toMSecsSinceEpoch() : 0;
+    stamp.bytes = fileinfo.size();
+    QString crc = Utility::FileCRC32(fullfilepath);
+    if (crc.isEmpty()) {
+        return QString();
+    }
+    stamp.key = crc + "-" + QString::number(stamp.bytes);
+    QMutexLocker locker(&m_Mutex);
+    m_Stamps.insert(fullfilepath, stamp);
+    return stamp.key;
+}
+
+
+bool ImageInfoCache::CachedEntry(const QString &key, int thumbnail_size, ImageInfo &info, QImage &thumbnail)
+{
+    QMutexLocker locker(&m_Mutex);
+    QHash<QString, ImageInfo>::const_iterator it = m_Infos.constFind(key);
+    if (it == m_Infos.constEnd()) {
+        return false;
+    }
+    if (thumbnail_size > 0) {
+        QImage *image = m_Thumbnails.object(key + "-" + QString::number(thumbnail_size));
+        if (!image) {
+            return false;
+        }
+        thumbnail = *image;
+    }
+    info = *it;
+    return true;
+}
+
+
+void ImageInfoCache::CacheEntry(const QString &key, int thumbnail_size, const ImageInfo &info, const QImage &thumbnail)
+{
+    QMutexLocker locker(&m_Mutex);
+    m_Infos.insert(key, info);
+    if (thumbnail_size > 0) {
+        m_Thumbnails.insert(key + "-" + QString::number(thumbnail_size),
+                            new QImage(thumbnail),
+                            static_cast<int>(thumbnail.sizeInBytes() / 1024) + 1);
+    }
+}
+
+
+// The info rides along as a text chunk of the thumbnail png (a 1x1
+// png for info alone) so it can be read back without any decoding
+bool ImageInfoCache::ReadDiskEntry(const QString &key, int thumbnail_size, ImageInfo &info, QImage &thumbnail) const
+{
+    QString path = m_CacheDir + "/" + key + "-" + QString::number(thumbnail_size) + ".png";
+    if (!USE_THUMBNAIL_DISK_CACHE || !QFileInfo::exists(path)) {
+        return false;
+    }
+
+    QImageReader reader(path, "png");
+    QStringList fields = reader.text(INFO_TEXT_KEY).split(' ');
+    if (fields.count() != 7) {
+        return false;
+    }
+    info.width = fields.at(0).toInt();
+    info.height = fields.at(1).toInt();
+    info.depth = fields.at(2).toInt();
+    info.bitPlaneCount = fields.at(3).toInt();
+    info.colorCount = fields.at(4).toInt();
+    info.grayscale = fields.at(5) == "1";
+    info.allGray = fields.at(6) == "1";
+    info.complete = true;
+    if (thumbnail_size > 0) {
+        thumbnail = reader.read();
+        if (thumbnail.isNull()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+void ImageInfoCache::WriteDiskEntry(const QString &key, int thumbnail_size, const ImageInfo &info, const QImage &thumbnail) const
+{
+    if (!USE_THUMBNAIL_DISK_CACHE) {
+        return;
+    }
+
+    QSaveFile file(m_CacheDir + "/" + key + "-" + QString::number(thumbnail_size) + ".png");
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QImageWriter writer(&file, "png");
+    writer.setText(INFO_TEXT_KEY, QString("%1 %2 %3 %4 %5 %6 %7")
+                   .arg(info.width).arg(info.height).arg(info.depth)
+                   .arg(info.bitPlaneCount).arg(info.colorCount)
+                   .arg(info.grayscale ? 1 : 0).arg(info.allGray ? 1 : 0));
+    QImage image = thumbnail;
+    if (thumbnail_size == 0) {
+        image = QImage(1, 1, QImage::Format_Mono);
+        image.fill(0);
+    }
+    if (writer.write(image)) {
+        file.commit();
+    } else {
+        file.cancelWriting();
+    }
+}
+
+
+void ImageInfoCache::Load(const QString &fullfilepath, int thumbnail_size, ImageInfo &info, QImage &thumbnail)
+{
+    QString key = FileKey(fullfilepath);
+    if (key.isEmpty()) {
+        info = ImageInfo();
+        info.complete = true;
+        return;
+    }
+    if (CachedEntry(key, thumbnail_size, info, thumbnail)) {
+        return;
+    }
+    if (ReadDiskEntry(key, thumbnail_size, info, thumbnail)) {
+        CacheEntry(key, thumbnail_size, info, thumbnail);
+        return;
+    }
+
+    Generate(fullfilepath, thumbnail_size, info, thumbnail);
+    CacheEntry(key, thumbnail_size, info, thumbnail);
+    // an image that could not be read may be fine the next time it is tried
+    if (info.width > 0) {
+        WriteDiskEntry(key, thumbnail_size, info, thumbnail);
+    }
+    DBG qDebug() << "ImageInfoCache generated" << fullfilepath << thumbnail_size;
+}
+
+
+// Safe on any thread: no QPixmaps, and the svg is rendered into a QImage
+void ImageInfoCache::Generate(const QString &fullfilepath, int thumbnail_size, ImageInfo &info, QImage &thumbnail)
+{
+    QImage image;
+    info = ImageInfo();
+    info.complete = true;
+
+    if (QFileInfo(fullfilepath).suffix().toLower() == "svg") {
+        try {
+            image = Utility::RenderSvgToImage(fullfilepath);
+        } catch (CannotOpenFile &) {
+        }
+        info.width = image.width();
+        info.height = image.height();
+        info.depth = image.depth();
+        info.bitPlaneCount = image.bitPlaneCount();
+    } else {
+        QImageReader reader(fullfilepath);
+        QSize size = reader.size();
+        QImage::Format format = reader.imageFormat();
+        // palette images are small and need their color table, so only
+        // direct color images are decoded straight to a smaller size
+        bool indexed = (format == QImage::Format_Indexed8) ||
+                       (format == QImage::Format_Mono) ||
+                       (format == QImage::Format_MonoLSB);
+        if (!indexed && (format != QImage::Format_Invalid) && size.isValid() &&
+            reader.supportsOption(QImageIOHandler::ScaledSize)) {
+            int box = qMax(thumbnail_size, ANALYSIS_SIZE);
+            if ((size.width() > box) || (size.height() > box)) {
+                reader.setScaledSize(size.scaled(box, box, Qt::KeepAspectRatio));
+            }
+        }
+        image = reader.read();
+        if (!size.isValid()) {
+            size = image.size();
+        }
+        if (format == QImage::Format_Invalid) {
+            format = image.format();
+        }
+        if (!image.isNull()) {
+            info.width = size.width();
+            info.height = size.height();
+            QImage pixel(1, 1, format);
+            info.depth = pixel.depth();
+            info.bitPlaneCount = pixel.bitPlaneCount();
+        }
+    }
+
+    info.colorCount = image.colorCount();
+    info.grayscale = !image.isNull() && image.isGrayscale();
+    // true for an image that cannot be read, as the Images report always had it
+    info.allGray = image.allGray();
+    if ((thumbnail_size > 0) && !image.isNull()) {
+        thumbnail = image;
+        if ((image.height() > thumbnail_size) || (image.width() > thumbnail_size)) {
+            thumbnail = image.scaled(QSize(thumbnail_size, thumbnail_size), Qt::KeepAspectRatio);
+        }
+    }
+}
+
+
+void ImageInfoCache::PruneDiskCache() const
+{
+    QDateTime oldest = QDateTime::currentDateTime().addDays(-MAX_THUMBNAIL_AGE);
+    QDir dir(m_CacheDir);
+    foreach(QFileInfo fileinfo, dir.entryInfoList(QStringList() << "*.png", QDir::Files)) {
+        if (fileinfo.lastModified() < oldest) {
+            QFile::remove(fileinfo.absoluteFilePath());
+        }
+    }
+}
@@ -0,0 +1,128 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+
+#pragma once
+#ifndef IMAGEINFOCACHE_H
+#define IMAGEINFOCACHE_H
+
+#include <QtCore/QCache>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+#include <QtGui/QImage>
+
+/**
+ * Singleton.
+ *
+ * The dimensions, colors, and thumbnails of image files shared by the
+ * Images report, the Select Files dialog, and image descriptions.
+ *
+ * Sizes and pixel formats are read from the image headers alone.
+ * Anything that needs the pixels (grayscale or not, the thumbnail) comes
+ * from one scaled decode done on a private thread pool, and is then kept
+ * in memory and in a thumbnail folder under the prefs dir keyed by the
+ * crc32 and size of the image file, so it is only ever worked out once.
+ */
+class ImageInfoCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct ImageInfo {
+        int width = 0;
+        int height = 0;
+        int depth = 0;
+        int bitPlaneCount = 0;
+        int colorCount = 0;
+        // as QImage::isGrayscale() and QImage::allGray() of the whole image
+        bool grayscale = false;
+        bool allGray = false;
+        // false when only the header fields (width, height, depth,
+        // bitPlaneCount) are known
+        bool complete = false;
+    };
+
+    static ImageInfoCache *instance();
+
+    // Returns the cached info, or else whatever the file's headers tell
+    // without decoding any of it (depth is 0 for formats that do not say)
+    ImageInfo HeaderInfo(const QString &fullfilepath);
+
+    // Returns the complete info, working it out on this thread if needed
+    ImageInfo Info(const QString &fullfilepath);
+
+    /**
+     * Returns true with the complete info and the thumbnail (no larger than
+     * thumbnail_size square, null for a size of 0) when both are cached.
+     * Otherwise returns false and has them made on the worker pool,
+     * emitting ThumbnailReady on the gui thread once they are.
+     */
+    bool RequestThumbnail(const QString &fullfilepath, int thumbnail_size,
+                          ImageInfo &info, QImage &thumbnail);
+
+signals:
+    void ThumbnailReady(const QString &fullfilepath, int thumbnail_size,
+                        const ImageInfoCache::ImageInfo &info, const QImage &thumbnail);
+
+private:
+    struct FileStamp {
+        qint64 modified;
+        qint64 bytes;
+        QString key;
+    };
+
+    ImageInfoCache();
+
+    // "crc32-bytes" for the file as it is now, or empty if not yet known
+    QString KnownFileKey(const QString &fullfilepath);
+
+    // as above but checksums the file if need be, empty if unreadable
+    QString FileKey(const QString &fullfilepath);
+
+    bool CachedEntry(const QString &key, int thumbnail_size, ImageInfo &info, QImage &thumbnail);
+    void CacheEntry(const QString &key, int thumbnail_size, const ImageInfo &info, const QImage &thumbnail);
+
+    bool ReadDiskEntry(const QString &key, int thumbnail_size, ImageInfo &info, QImage &thumbnail) const;
+    void WriteDiskEntry(const QString &key, int thumbnail_size, const ImageInfo &info, const QImage &thumbnail) const;
+
+    void Load(const QString &fullfilepath, int thumbnail_size, ImageInfo &info, QImage &thumbnail);
+    static void Generate(const QString &fullfilepath, int thumbnail_size, ImageInfo &info, QImage &thumbnail);
+
+    void PruneDiskCache() const;
+
+    QString m_CacheDir;
+
+    QThreadPool m_Pool;
+
+    // guards all of the members below
+    QMutex m_Mutex;
+
+    QHash<QString, FileStamp> m_Stamps;
+    QHash<QString, ImageInfo> m_Infos;
+    QCache<QString, QImage> m_Thumbnails;
+    QSet<QString> m_Pending;
+};
+
+#endif // IMAGEINFOCACHE_H
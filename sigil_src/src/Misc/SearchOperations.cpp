@@ -24,14 +24,17 @@
 #include <signal.h>
 
 #include <QtCore/QtCore>
+#include <QtConcurrent/QtConcurrent>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QProgressDialog>
 
 #include "BookManipulation/CleanSource.h"
+#include "Misc/FutureProgress.h"
 #include "Misc/SearchOperations.h"
 #include "Misc/SettingsStore.h"
 #include "Misc/Utility.h"
 #include "PCRE2/PCRECache.h"
+#include "PCRE2/PCREReplaceTextBuilder.h"
 #include "Misc/HTMLSpellCheck.h"
 #include "ResourceObjects/HTMLResource.h"
 #include "ResourceObjects/TextResource.h"
@@ -43,18 +46,33 @@ int SearchOperations::CountInFiles(const QString &search_regex,
                                    QList<Resource *> resources,
                                    bool check_spelling)
 {
-    QProgressDialog progress(QObject::tr("Counting occurrences.."), 0, 0, resources.count(), Utility::GetMainWindow());
+    QProgressDialog progress(QObject::tr("Counting occurrences.."), QObject::tr("Abort"), 0, resources.count(), Utility::GetMainWindow());
     progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
     int progress_value = 0;
     progress.setValue(progress_value);
-    // Count sequentially in order to see if occassional crashes are due to threading
     int count = 0;
-    foreach(Resource * resource, resources) {
-        progress.setValue(progress_value++);
-        qApp->processEvents();
-        count += CountInFile(search_regex, resource, check_spelling);
+
+    // The spellchecker is not thread safe so count misspelled words sequentially
+    if (check_spelling) {
+        foreach(Resource * resource, resources) {
+            if (progress.wasCanceled()) break;
+            progress.setValue(progress_value++);
+            qApp->processEvents();
+            count += CountInFile(search_regex, resource, check_spelling);
+        }
+        return count;
     }
-    return count;
+
+    // compile the regex once here instead of in every worker thread
+    PCRECache::instance()->getObject(search_regex);
+    // a canceled future drops its results, so the workers add up the total
+    // themselves and an abort still reports the files already counted
+    QAtomicInt total(0);
+    QFuture<void> future = QtConcurrent::map(resources, [&search_regex, &total](Resource *resource) {
+        total.fetchAndAddRelaxed(CountInFile(search_regex, resource, false));
+    });
+    FutureProgress::Wait(future, progress);
+    return total.loadRelaxed();
 }
 
 
@@ -62,18 +80,20 @@ int SearchOperations::ReplaceInAllFIles(const QString &search_regex,
                                         const QString &replacement,
                                         QList<Resource *> resources)
 {
-    QProgressDialog progress(QObject::tr("Replacing search term..."), 0, 0, resources.count(), Utility::GetMainWindow());
+    QProgressDialog progress(QObject::tr("Replacing search term..."), QObject::tr("Abort"), 0, resources.count(), Utility::GetMainWindow());
     progress.setMinimumDuration(PROGRESS_BAR_MINIMUM_DURATION);
-    int progress_value = 0;
-    progress.setValue(progress_value);
-    // Replace sequentially in order to see if occassional crashes are due to threading
-    int count = 0;
-    foreach(Resource * resource, resources) {
-        progress.setValue(progress_value++);
-        qApp->processEvents();
-        count += ReplaceInFile(search_regex, replacement, resource);
-    }
-    return count;
+    progress.setValue(0);
+
+    // compile the regex once here instead of in every worker thread
+    PCRECache::instance()->getObject(search_regex);
+    // if canceled the files already processed keep their replacements, and
+    // as a canceled future drops its results the workers keep the total
+    QAtomicInt total(0);
+    QFuture<void> future = QtConcurrent::map(resources, [&search_regex, &replacement, &total](Resource *resource) {
+        total.fetchAndAddRelaxed(ReplaceInFile(search_regex, replacement, resource));
+    });
+    FutureProgress::Wait(future, progress);
+    return total.loadRelaxed();
 }
 
 
@@ -157,7 +177,9 @@ int SearchOperations::ReplaceHTMLInFile(const QString &search_regex,
     QString new_text;
     QString text = html_resource->GetText();
     std::tie(new_text, count) = PerformGlobalReplace(text, search_regex, replacement);
-    html_resource->SetText(new_text);
+    if (count > 0) {
+        html_resource->SetText(new_text);
+    }
     return count;
  }
 
@@ -171,7 +193,9 @@ int SearchOperations::ReplaceTextInFile(const QString &search_regex,
     QString new_text;
     QString text = text_resource->GetText();
     std::tie(new_text, count) = PerformGlobalReplace(text, search_regex, replacement);
-    text_resource->SetText(new_text);
+    if (count > 0) {
+        text_resource->SetText(new_text);
+    }
     return count;
 }
 
@@ -180,20 +204,46 @@ std::tuple<QString, int> SearchOperations::PerformGlobalReplace(const QString &t
         const QString &search_regex,
         const QString &replacement)
 {
-    QString new_text = text;
     int count = 0;
-    SPCRE *spcre = PCRECache::instance()->getObject(search_regex);
+    QSharedPointer<SPCRE> spcre = PCRECache::instance()->getObject(search_regex);
     QList<SPCRE::MatchInfo> match_info = spcre->getEveryMatchInfo(text);
+    if (match_info.isEmpty()) {
+        return std::make_tuple(text, count);
+    }
 
-    for (int i =  match_info.count() - 1; i >= 0; i--) {
-        QString match_segement = Utility::Substring(match_info.at(i).offset.first, match_info.at(i).offset.second, new_text);
-        QString replacement_text;
+    // Function replacements are handled per match by python
+    // and are applied from the last match to the first
+    QString rname = replacement.trimmed();
+    if (rname.startsWith("\\F<") && rname.endsWith(">")) {
+        QString new_text = text;
+        for (int i =  match_info.count() - 1; i >= 0; i--) {
+            QString match_segement = Utility::Substring(match_info.at(i).offset.first, match_info.at(i).offset.second, new_text);
+            QString replacement_text;
 
-        if (spcre->replaceText(match_segement, match_info.at(i).capture_groups_offsets, replacement, replacement_text)) {
-            new_text.replace(match_info.at(i).offset.first, match_info.at(i).offset.second - match_info.at(i).offset.first, replacement_text);
-            count++;
+            if (spcre->replaceText(match_segement, match_info.at(i).capture_groups_offsets, replacement, replacement_text)) {
+                new_text.replace(match_info.at(i).offset.first, match_info.at(i).offset.second - match_info.at(i).offset.first, replacement_text);
+                count++;
+            }
         }
+        return std::make_tuple(new_text, count);
+    }
+
+    // Otherwise parse the replacement once and build the new text
+    // in a single forward pass copying the text between the matches
+    PCREReplaceTextBuilder builder;
+    if (!builder.CompileReplacementPattern(*spcre, replacement)) {
+        return std::make_tuple(text, count);
+    }
+    QString new_text;
+    new_text.reserve(text.length() + match_info.count() * qMax(0, replacement.length() - 1));
+    int last_end = 0;
+    foreach(const SPCRE::MatchInfo &match, match_info) {
+        new_text.append(QStringView(text).mid(last_end, match.offset.first - last_end));
+        builder.AppendReplacementText(text, match.offset.first, match.capture_groups_offsets, new_text);
+        last_end = match.offset.second;
+        count++;
     }
+    new_text.append(QStringView(text).mid(last_end));
 
     return std::make_tuple(new_text, count);
 }
@@ -206,7 +256,7 @@ std::tuple<QString, int> SearchOperations::PerformHTMLSpellCheckReplace(const QS
     QString new_text = text;
     int count = 0;
     int offset = 0;
-    SPCRE *spcre = PCRECache::instance()->getObject(search_regex);
+    QSharedPointer<SPCRE> spcre = PCRECache::instance()->getObject(search_regex);
     QList<HTMLSpellCheck::MisspelledWord> check_spelling = HTMLSpellCheck::GetMisspelledWords(text, 0, text.length(), search_regex);
     foreach(HTMLSpellCheck::MisspelledWord misspelled_word, check_spelling) {
         SPCRE::MatchInfo match_info = spcre->getFirstMatchInfo(misspelled_word.text);
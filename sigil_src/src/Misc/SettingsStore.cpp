@@ -22,6 +22,7 @@
 **
 *************************************************************************/
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QLocale>
 #include <QtCore/QCoreApplication>
 #include <QPalette>
@@ -139,6 +140,9 @@ static QString KEY_SPECIAL_CHARACTER_FONT_SIZE = SETTINGS_GROUP + "/" + "special
 static QString KEY_MAIN_MENU_ICON_SIZE = SETTINGS_GROUP + "/" + "main_menu_icon_size";
 static QString KEY_CLIPBOARD_HISTORY_LIMIT = SETTINGS_GROUP + "/" + "clipboard_history_limit";
 
+// bumped by every setPreserveEntityCodeNames
+static QAtomicInt preserve_entity_revision(0);
+
 SettingsStore::SettingsStore()
     : QSettings(Utility::DefinePrefsDir() + "/" + SETTINGS_FILE, QSettings::IniFormat)
 {  
@@ -368,6 +372,11 @@ QList <std::pair <ushort, QString>>  SettingsStore::preserveEntityCodeNames()
     return codenames;
 }
 
+int SettingsStore::preserveEntityCodeNamesRevision()
+{
+    return preserve_entity_revision.loadAcquire();
+}
+
 QHash <QString, QString> SettingsStore::pluginEnginePaths()
 {
     QHash <QString, QVariant> ep;
@@ -737,6 +746,7 @@ void SettingsStore::setPreserveEntityCodeNames(const QList<std::pair <ushort, QS
     }
     setValue(KEY_PRESERVE_ENTITY_NAMES, names);
     setValue(KEY_PRESERVE_ENTITY_CODES, codes);
+    preserve_entity_revision.ref();
 }
 
 void SettingsStore::setPluginEnginePaths(const QHash <QString, QString> &enginepaths)
@@ -103,6 +103,12 @@ public:
 
     QList<std::pair <ushort, QString>>  preserveEntityCodeNames();
 
+    /**
+     * Changes whenever the list of entities/code pairs to preserve
+     * is set, so anything derived from that list can be cached.
+     */
+    static int preserveEntityCodeNamesRevision();
+
     /**
      * Support for Plugins
      */
@@ -47,6 +47,10 @@
 
 #define DBG if(0)
 
+// Most text is made up of a small number of distinct words so this
+// easily covers a whole book, past it the cache simply starts over
+static const int MAX_CACHED_VERDICTS = 100000;
+
 #if !defined(Q_OS_WIN32) && !defined(Q_OS_MAC)
 # include <stdlib.h>
 #endif
@@ -146,6 +150,7 @@ void SpellCheck::UnloadDictionary(const QString &dname)
         }
         m_opendicts.remove(dname);
     }
+    clearVerdictCache();
 }
 
 void SpellCheck::UnloadAllDictionaries()
@@ -211,9 +216,15 @@ bool SpellCheck::spell(const QString &word)
     Q_ASSERT(hdic.encoder != nullptr);
     Q_ASSERT(hdic.decoder != nullptr);
     Q_ASSERT(hdic.handle != nullptr);
-    QByteArray ba = hdic.encoder->encode(Utility::getSpellingSafeText(HTMLSpellCheckML::textOf(word)));
-    bool res = hdic.handle->spell(ba.toStdString());    
-    res = res || isIgnored(HTMLSpellCheckML::textOf(word));
+    QString text = HTMLSpellCheckML::textOf(word);
+    QString key = dname + QChar(0) + QChar(0) + text;
+    bool res;
+    if (!cachedVerdict(key, res)) {
+        QByteArray ba = hdic.encoder->encode(Utility::getSpellingSafeText(text));
+        res = hdic.handle->spell(ba.toStdString());
+        cacheVerdict(key, res);
+    }
+    res = res || isIgnored(text);
     return res;
 }
 
@@ -225,12 +236,54 @@ bool SpellCheck::spellPS(const QString &word)
 {
     if (!m_primary.handle) return true;
     if(m_ignoredWords.contains(word)) return true;
+    QString key = m_primary.name + QChar(0) + m_secondary.name + QChar(0) + word;
+    bool res;
+    if (cachedVerdict(key, res)) return res;
     QByteArray pba = m_primary.encoder->encode(Utility::getSpellingSafeText(word));
-    bool res = m_primary.handle->spell(pba.toStdString());
-    if (res) return true;
-    if (!m_secondary.handle) return false;
-    QByteArray sba = m_secondary.encoder->encode(Utility::getSpellingSafeText(word));
-    return m_secondary.handle->spell(sba.toStdString());
+    res = m_primary.handle->spell(pba.toStdString());
+    if (!res && m_secondary.handle) {
+        QByteArray sba = m_secondary.encoder->encode(Utility::getSpellingSafeText(word));
+        res = m_secondary.handle->spell(sba.toStdString());
+    }
+    cacheVerdict(key, res);
+    return res;
+}
+
+
+// Only the dictionaries' own verdicts are cached, ignored words are
+// still checked on every call so ignoring a word needs no invalidation
+bool SpellCheck::cachedVerdict(const QString &key, bool &verdict)
+{
+    QMutexLocker locker(&m_verdictMutex);
+    QHash<QString, bool>::const_iterator it = m_verdicts.constFind(key);
+    if (it == m_verdicts.constEnd()) {
+        m_verdictMisses.ref();
+        return false;
+    }
+    verdict = it.value();
+    m_verdictHits.ref();
+    return true;
+}
+
+
+void SpellCheck::cacheVerdict(const QString &key, bool verdict)
+{
+    QMutexLocker locker(&m_verdictMutex);
+    if (m_verdicts.size() >= MAX_CACHED_VERDICTS) {
+        m_verdicts.clear();
+    }
+    m_verdicts.insert(key, verdict);
+}
+
+
+// Must be called whenever a dictionary is loaded, unloaded or has words added
+void SpellCheck::clearVerdictCache()
+{
+    QMutexLocker locker(&m_verdictMutex);
+    DBG qDebug() << "spell verdict cache hits: " << m_verdictHits.loadRelaxed()
+                 << " misses: " << m_verdictMisses.loadRelaxed()
+                 << " entries: " << m_verdicts.size();
+    m_verdicts.clear();
 }
 
 
@@ -315,6 +368,7 @@ void SpellCheck::addWordToDictionary(const QString &word, const QString &dname)
         HDictionary hdic = m_opendicts[dname];
         QByteArray ba = hdic.encoder->encode(Utility::getSpellingSafeText(HTMLSpellCheckML::textOf(word)));
         hdic.handle->add(ba.toStdString());
+        clearVerdictCache();
     }
 }
 
@@ -395,6 +449,7 @@ void SpellCheck::loadDictionary(const QString &dname)
     else if (dname == settings.secondary_dictionary()) {
         m_secondary = hdic;
     }
+    clearVerdictCache();
     return;
 }
 
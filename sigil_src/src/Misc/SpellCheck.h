@@ -28,6 +28,7 @@
 #include <QString>
 #include <QStringList>
 #include <QMutex>
+#include <QAtomicInt>
 
 class Hunspell;
 class QStringEncoder;
@@ -93,6 +94,13 @@ public:
 
 private:
     SpellCheck();
+
+    // Hunspell verdicts keyed by dictionary pair and word, shared by
+    // everything that spell checks through this singleton
+    bool cachedVerdict(const QString &key, bool &verdict);
+    void cacheVerdict(const QString &key, bool verdict);
+    void clearVerdictCache();
+
     QHash<QString, QString> m_dictionaries;
     QHash<QString, QString> m_langcode2dict;
     mutable QMutex mutex;
@@ -100,7 +108,12 @@ private:
     QSet<QString> m_ignoredWords;
     struct HDictionary m_primary;
     struct HDictionary m_secondary;
-    
+
+    QHash<QString, bool> m_verdicts;
+    QMutex m_verdictMutex;
+    QAtomicInt m_verdictHits;
+    QAtomicInt m_verdictMisses;
+
     static SpellCheck *m_instance;
 };
 
@@ -139,8 +139,10 @@ public:
     static QString ReadUnicodeTextFile(const QString &fullfilepath);
 
     // Writes the provided text variable to the specified
-    // file; if the file exists, it is truncated
-    static void WriteUnicodeTextFile(const QString &text, const QString &fullfilepath);
+    // file; if the file exists, it is truncated;
+    // returns the crc32 checksum of the data written
+    // (as FileCRC32 would report it for that file)
+    static QString WriteUnicodeTextFile(const QString &text, const QString &fullfilepath);
 
     // Converts Mac and Windows style line endings to Unix style
     // line endings that are expected throughout the Qt framework
@@ -259,6 +261,9 @@ public:
     // Generate a CRC32 checksum on a file
     static QString FileCRC32(const QString& filepath);
 
+    // Generate a CRC32 checksum on a block of data
+    static QString DataCRC32(const QByteArray& data);
+
     // Added to work around macOS specific QMessageBox issues with reactivating proper window upon return
     static QMessageBox::StandardButton warning(QWidget *parent, const QString &title, const QString &text,
                                                QMessageBox::StandardButtons buttons = QMessageBox::Ok,
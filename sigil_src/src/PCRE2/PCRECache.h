@@ -26,6 +26,8 @@
 #define PCRECACHE_H
 
 #include <QtCore/QCache>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QString>
 
 #include "PCRE2/SPCRE.h"
@@ -34,6 +36,10 @@
  * Singleton. A cache of SPCRE regular expression objects.
  *
  * The SPCRE's are cached to improve performance.
+ *
+ * The cache may be used from multiple threads. Objects are handed out
+ * as shared pointers so that one being used by another thread stays
+ * alive even if it is evicted from the cache in the meantime.
  */
 class PCRECache
 {
@@ -62,7 +68,7 @@ public:
      *
      * @param key The key associated with the SPCRE.
      */
-    SPCRE *getObject(const QString &key);
+    QSharedPointer<SPCRE> getObject(const QString &key);
 
 private:
     /**
@@ -71,7 +77,9 @@ private:
     PCRECache();
 
     // The cache that we store the SPCRE's.
-    QCache<QString, SPCRE> m_cache;
+    QCache<QString, QSharedPointer<SPCRE> > m_cache;
+    // Guards access to the cache.
+    QMutex m_mutex;
     // The single instance of the cache.
     static PCRECache *m_instance;
 };
@@ -23,7 +23,6 @@
 #include <QtCore/QChar>
 
 #include "PCRE2/PCREReplaceTextBuilder.h"
-#include "Misc/Utility.h"
 
 #define is_hex(a) (((a) >= '0' && (a) <= '9') || ((a) >= 'a' && (a) <= 'f') || ((a) >= 'A' && (a) <= 'F') ? true : false)
 
@@ -50,6 +49,16 @@ bool PCREReplaceTextBuilder::BuildReplacementText(SPCRE &sre,
         const QList<std::pair<int, int>> &capture_groups_offsets,
         const QString &replacement_pattern,
         QString &out)
+{
+    if (!CompileReplacementPattern(sre, replacement_pattern)) {
+        return false;
+    }
+    out.clear();
+    AppendReplacementText(text, 0, capture_groups_offsets, out);
+    return true;
+}
+
+bool PCREReplaceTextBuilder::CompileReplacementPattern(SPCRE &sre, const QString &replacement_pattern)
 {
     resetState();
 
@@ -59,11 +68,11 @@ bool PCREReplaceTextBuilder::BuildReplacementText(SPCRE &sre,
 
     // Check if the \ start control is in the string.
     // If it's not we don't need to run though the replacment code and we
-    // can just return the pattern as the replaced text.
+    // can just use the pattern as the replaced text.
     // This is a simple and quick way that will catch a large number of
     // cases but not all.
     if (!replacement_pattern.contains("\\")) {
-        out = replacement_pattern;
+        addLiteral(replacement_pattern);
         return true;
     }
 
@@ -132,45 +141,41 @@ bool PCREReplaceTextBuilder::BuildReplacementText(SPCRE &sre,
                 if (c.isDigit()) {
                     int backref_number = c.digitValue();
 
-                    // Check if this number is a back reference we can
-                    // actually get.
-                    if (backref_number >= 0 && backref_number < capture_groups_offsets.count()) {
-                        accumulateReplcementText(Utility::Substring(capture_groups_offsets.at(backref_number).first, capture_groups_offsets.at(backref_number).second, text));
-                    } else {
-                        accumulateReplcementText(invalid_control);
-                    }
+                    // Whether this is a back reference we can actually
+                    // get is only known once we have the match.
+                    addBackReference(backref_number, invalid_control);
 
                     in_control = false;
                 }
                 // Metacharacters
                 else if (c == 'a') {
-                    accumulateReplcementText("\a");
+                    addLiteral("\a");
                     in_control = false;
                 } else if (c == 'b') {
-                    accumulateReplcementText("\b");
+                    addLiteral("\b");
                     in_control = false;
                 } else if (c == 'f') {
-                    accumulateReplcementText("\f");
+                    addLiteral("\f");
                     in_control = false;
                 } else if (c == 'n') {
-                    accumulateReplcementText("\n");
+                    addLiteral("\n");
                     in_control = false;
                 } else if (c == 'r') {
-                    accumulateReplcementText("\r");
+                    addLiteral("\r");
                     in_control = false;
                 } else if (c == 't') {
-                    accumulateReplcementText("\t");
+                    addLiteral("\t");
                     in_control = false;
                 } else if (c == 'v') {
-                    accumulateReplcementText("\v");
+                    addLiteral("\v");
                     in_control = false;
                 } else if (c == '\\') {
-                    accumulateReplcementText("\\");
+                    addLiteral("\\");
                     in_control = false;
                 }
                 // End case change.
                 else if (c == 'E') {
-                    m_caseChangeState = CaseChange_None;
+                    addCaseChange(CaseChange_None);
                     in_control = false;
                 }
                 // Backreference.
@@ -179,22 +184,22 @@ bool PCREReplaceTextBuilder::BuildReplacementText(SPCRE &sre,
                 }
                 // Lower case next character.
                 else if (c == 'l') {
-                    trySetCaseChange(CaseChange_LowerNext);
+                    addCaseChange(CaseChange_LowerNext);
                     in_control = false;
                 }
                 // Lower case until \E.
                 else if (c == 'L') {
-                    trySetCaseChange(CaseChange_Lower);
+                    addCaseChange(CaseChange_Lower);
                     in_control = false;
                 }
                 // Upper case next character.
                 else if (c == 'u') {
-                    trySetCaseChange(CaseChange_UpperNext);
+                    addCaseChange(CaseChange_UpperNext);
                     in_control = false;
                 }
                 // Upper case until \E.
                 else if (c == 'U') {
-                    trySetCaseChange(CaseChange_Upper);
+                    addCaseChange(CaseChange_Upper);
                     in_control = false;
                 }
             }
@@ -209,7 +214,7 @@ bool PCREReplaceTextBuilder::BuildReplacementText(SPCRE &sre,
                             backref_name.clear();
                         } else {
                             in_control = false;
-                            accumulateReplcementText(invalid_control);
+                            addLiteral(invalid_control);
                         }
                     } else {
                         if ((c == '}' && backref_bracket_start_char == '{') ||
@@ -225,13 +230,9 @@ bool PCREReplaceTextBuilder::BuildReplacementText(SPCRE &sre,
                                 backref_number = sre.getCaptureStringNumber(backref_name);
                             }
 
-                            // Check if there is we have a back reference we can
-                            // actually get.
-                            if (backref_number >= 0 && backref_number < capture_groups_offsets.count()) {
-                                accumulateReplcementText(Utility::Substring(capture_groups_offsets.at(backref_number).first, capture_groups_offsets.at(backref_number).second, text));
-                            } else {
-                                accumulateReplcementText(invalid_control);
-                            }
+                            // Whether this is a back reference we can actually
+                            // get is only known once we have the match.
+                            addBackReference(backref_number, invalid_control);
 
                             in_control = false;
                         } else {
@@ -244,14 +245,14 @@ bool PCREReplaceTextBuilder::BuildReplacementText(SPCRE &sre,
                     } else if (c == '}' && in_hex6 && IsValidHex6(control_x6_hex)) {
                         int hl = control_x6_hex.length();
                         if (hl == 2 || hl == 4) {
-                            accumulateReplcementText(QChar(control_x6_hex.toUInt(NULL, 16)));
+                            addLiteral(QChar(control_x6_hex.toUInt(NULL, 16)));
                         } else {
                             uint achar;
                             QString extended_plane = control_x6_hex.left(2);
                             QString remainder = control_x6_hex.right(4);
                             achar = remainder.toUInt(NULL, 16);
                             achar = (65536 * extended_plane.toUInt(NULL, 16)) + achar;
-                            accumulateReplcementText(QString::fromUcs4(reinterpret_cast<char32_t*>(&achar), 1));
+                            addLiteral(QString::fromUcs4(reinterpret_cast<char32_t*>(&achar), 1));
                         }
                         in_control = false;
                         in_hex6 = false;
@@ -262,18 +263,18 @@ bool PCREReplaceTextBuilder::BuildReplacementText(SPCRE &sre,
                         } else {
                             control_x_hex += c;
                             if (control_x_hex.length() == 2) {
-                                accumulateReplcementText(QChar(control_x_hex.toUInt(NULL, 16)));
+                                addLiteral(QChar(control_x_hex.toUInt(NULL, 16)));
                                 in_control = false;
                             }
                         }
                     } else {
-                        accumulateReplcementText(invalid_control);
+                        addLiteral(invalid_control);
                         in_control = false;
                     }
                 }
                 // Invalid or unsupported control.
                 else {
-                    accumulateReplcementText(invalid_control);
+                    addLiteral(invalid_control);
                     in_control = false;
                 }
             }
@@ -296,7 +297,7 @@ bool PCREReplaceTextBuilder::BuildReplacementText(SPCRE &sre,
             }
             // Normal text.
             else {
-                accumulateReplcementText(c);
+                addLiteral(c);
             }
         }
     }
@@ -305,63 +306,114 @@ bool PCREReplaceTextBuilder::BuildReplacementText(SPCRE &sre,
     // a back reference then we have an invalid back reference because
     // it never ended. Put the invalid reference into the replacment string.
     if (in_control) {
-        accumulateReplcementText(invalid_control);
+        addLiteral(invalid_control);
     }
 
-    out = m_finalText;
     return true;
 }
 
-void PCREReplaceTextBuilder::accumulateReplcementText(const QChar &ch)
+void PCREReplaceTextBuilder::AppendReplacementText(const QString &text,
+        int match_start,
+        const QList<std::pair<int, int>> &capture_groups_offsets,
+        QString &out)
 {
-    m_finalText += processTextSegement(ch);
+    m_caseChangeState = CaseChange_None;
+    foreach(const ReplacementSegment &segment, m_segments) {
+        switch (segment.type) {
+            case Segment_Literal:
+                appendProcessedText(QStringView(segment.text), out);
+                break;
+
+            case Segment_BackReference:
+                if (segment.backref_number >= 0 && segment.backref_number < capture_groups_offsets.count()) {
+                    const std::pair<int, int> &group = capture_groups_offsets.at(segment.backref_number);
+                    appendProcessedText(QStringView(text).mid(match_start + group.first, group.second - group.first), out);
+                } else {
+                    appendProcessedText(QStringView(segment.text), out);
+                }
+                break;
+
+            case Segment_CaseChange:
+                if (segment.case_change == CaseChange_None) {
+                    m_caseChangeState = CaseChange_None;
+                } else {
+                    trySetCaseChange(segment.case_change);
+                }
+                break;
+        }
+    }
 }
 
-void PCREReplaceTextBuilder::accumulateReplcementText(const QString &text)
+void PCREReplaceTextBuilder::addLiteral(const QChar &ch)
 {
-    m_finalText += processTextSegement(text);
+    addLiteral(QString(ch));
 }
 
-QString PCREReplaceTextBuilder::processTextSegement(const QChar &ch)
+void PCREReplaceTextBuilder::addLiteral(const QString &text)
 {
-    return processTextSegement(QString(ch));
+    if (text.isEmpty()) {
+        return;
+    }
+    // Adjacent text is merged since case changes treat it the same
+    // whether it is processed in one piece or character by character.
+    if (!m_segments.isEmpty() && m_segments.last().type == Segment_Literal) {
+        m_segments.last().text += text;
+        return;
+    }
+    ReplacementSegment segment;
+    segment.type = Segment_Literal;
+    segment.text = text;
+    m_segments.append(segment);
 }
 
-QString PCREReplaceTextBuilder::processTextSegement(const QString &text)
+void PCREReplaceTextBuilder::addBackReference(int backref_number, const QString &invalid_control)
 {
-    QString processedText;
+    ReplacementSegment segment;
+    segment.type = Segment_BackReference;
+    segment.backref_number = backref_number;
+    segment.text = invalid_control;
+    m_segments.append(segment);
+}
+
+void PCREReplaceTextBuilder::addCaseChange(CaseChange state)
+{
+    ReplacementSegment segment;
+    segment.type = Segment_CaseChange;
+    segment.case_change = state;
+    m_segments.append(segment);
+}
 
+void PCREReplaceTextBuilder::appendProcessedText(QStringView text, QString &out)
+{
     if (text.length() == 0) {
-        return processedText;
+        return;
     }
 
     switch (m_caseChangeState) {
         case CaseChange_LowerNext:
-            processedText += text.at(0).toLower();
-            processedText += text.mid(1);
+            out += text.at(0).toLower();
+            out += text.mid(1);
             m_caseChangeState = CaseChange_None;
             break;
 
         case CaseChange_Lower:
-            processedText += text.toLower();
+            out += text.toString().toLower();
             break;
 
         case CaseChange_UpperNext:
-            processedText += text.at(0).toUpper();
-            processedText += text.mid(1);
+            out += text.at(0).toUpper();
+            out += text.mid(1);
             m_caseChangeState = CaseChange_None;
             break;
 
         case CaseChange_Upper:
-            processedText += text.toUpper();
+            out += text.toString().toUpper();
             break;
 
         default:
-            processedText += text;
+            out += text;
             break;
     }
-
-    return processedText;
 }
 
 void PCREReplaceTextBuilder::trySetCaseChange(CaseChange state)
@@ -373,6 +425,6 @@ void PCREReplaceTextBuilder::trySetCaseChange(CaseChange state)
 
 void PCREReplaceTextBuilder::resetState()
 {
-    m_finalText.clear();
+    m_segments.clear();
     m_caseChangeState = CaseChange_None;
 }
@@ -25,7 +25,9 @@
 #ifndef PCREREPLACETEXTBUILDER_H
 #define PCREREPLACETEXTBUILDER_H
 
+#include <QtCore/QList>
 #include <QtCore/QString>
+#include <QtCore/QStringView>
 
 #include "PCRE2/SPCRE.h"
 
@@ -61,6 +63,32 @@ public:
                               const QString &replacement_pattern,
                               QString &out);
 
+    /**
+     * Parse a replacement pattern once so it can be applied to many matches.
+     *
+     * @param sre The SPCRE.
+     * @param replacement_pattern The replacement pattern. Can be text or text
+     * and control characters.
+     *
+     * @return True if the replacement pattern can be used.
+     */
+    bool CompileReplacementPattern(SPCRE &sre, const QString &replacement_pattern);
+
+    /**
+     * Append the replacement text for one match using the replacement
+     * pattern given to CompileReplacementPattern.
+     *
+     * @param text The text containing the match.
+     * @param match_start The offset of the match within text.
+     * @param capture_groups_offsets The offsets relative to match_start
+     * representing the captured subpatterns.
+     * @param[out] out The string the replacement is appended to.
+     */
+    void AppendReplacementText(const QString &text,
+                               int match_start,
+                               const QList<std::pair<int, int>> &capture_groups_offsets,
+                               QString &out);
+
 private:
     /**
      * The state of case changes.
@@ -81,40 +109,57 @@ private:
     bool IsValidHex6(QString& hv);
     
     /**
-     * Add to the final replacement text we are building.
-     *
-     * Processes by calling processTextSegement before adding.
-     *
-     * @param ch The character to add.
+     * The kinds of pieces a replacement pattern is parsed into.
      */
-    void accumulateReplcementText(const QChar &ch);
+    enum SegmentType {
+        Segment_Literal,
+        Segment_BackReference,
+        Segment_CaseChange
+    };
+
     /**
-     * Add to the final replacement text we are building.
-     *
-     * Processes by calling processTextSegement before adding.
+     * One parsed piece of the replacement pattern.
+     */
+    struct ReplacementSegment {
+        SegmentType type;
+        // The literal text, or for a back reference the text to use
+        // when the capture group does not exist.
+        QString text;
+        int backref_number = -1;
+        CaseChange case_change = CaseChange_None;
+    };
+
+    /**
+     * Add text that is copied into every replacement.
      *
      * @param text The text to add.
      */
-    void accumulateReplcementText(const QString &text);
+    void addLiteral(const QChar &ch);
+    void addLiteral(const QString &text);
 
     /**
-     * Processes the text segment making any changes necessary based upon
-     * the state.
+     * Add a numbered back reference.
      *
-     * @param ch The character to process.
+     * @param backref_number The capture group number.
+     * @param invalid_control The text to use if the group does not exist.
+     */
+    void addBackReference(int backref_number, const QString &invalid_control);
+
+    /**
+     * Add a case change where CaseChange_None ends any case change.
      *
-     * @return The processed and transformed text.
+     * @param state The case change.
      */
-    QString processTextSegement(const QChar &ch);
+    void addCaseChange(CaseChange state);
+
     /**
-     * Processes the text segment making any changes necessary based upon
-     * the state.
+     * Appends the text making any changes necessary based upon
+     * the case change state.
      *
      * @param text The text to process.
-     *
-     * @return The processed and transformed text.
+     * @param[out] out The string to append to.
      */
-    QString processTextSegement(const QString &text);
+    void appendProcessedText(QStringView text, QString &out);
 
     /**
      * Change the case state if possible.
@@ -128,8 +173,8 @@ private:
 
     // Case change state.
     CaseChange m_caseChangeState;
-    // The final replacement text.
-    QString m_finalText;
+    // The parsed replacement pattern.
+    QList<ReplacementSegment> m_segments;
 };
 
 #endif // PCREREPLACETEXTBUILDER_H
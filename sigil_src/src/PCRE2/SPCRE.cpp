@@ -30,22 +30,75 @@
 #include "Misc/SearchUtils.h"
 #include "sigil_constants.h"
 
-#define PCRE_NO_JIT 1
-
 // The maximum number of catpures that we will allow.
 const int PCRE_MAX_CAPTURE_GROUPS = 30;
 
+// JIT compilation can be turned off if it misbehaves on a given platform
+static const bool USE_PCRE_JIT = !qEnvironmentVariableIsSet("SIGIL_DISABLE_PCRE_JIT");
+
+// The JIT stack, match context and match data may not be used by two threads
+// at the same time, so each thread gets its own set to share among all of
+// the SPCRE objects it uses.
+class SPCREThreadData
+{
+public:
+    SPCREThreadData()
+      : m_jitstack(NULL),
+        m_mcontext(NULL),
+        m_matchdata(NULL)
+    {
+        m_mcontext = pcre2_match_context_create_16(NULL);
+        if (USE_PCRE_JIT && (m_mcontext != NULL)) {
+            m_jitstack = pcre2_jit_stack_create_16(32*1024, 1024*1024, NULL);
+            if (m_jitstack != NULL) {
+                pcre2_jit_stack_assign_16(m_mcontext, NULL, m_jitstack);
+            }
+        }
+    }
+
+    ~SPCREThreadData()
+    {
+        if (m_matchdata) pcre2_match_data_free_16(m_matchdata);
+        if (m_mcontext) pcre2_match_context_free_16(m_mcontext);
+        if (m_jitstack) pcre2_jit_stack_free_16(m_jitstack);
+    }
+
+    pcre2_match_context_16 *matchContext()
+    {
+        return m_mcontext;
+    }
+
+    // grow the match data as needed so it can hold every capture group
+    pcre2_match_data_16 *matchData(uint32_t ovector_count)
+    {
+        if ((m_matchdata != NULL) && (pcre2_get_ovector_count_16(m_matchdata) < ovector_count)) {
+            pcre2_match_data_free_16(m_matchdata);
+            m_matchdata = NULL;
+        }
+        if (m_matchdata == NULL) {
+            m_matchdata = pcre2_match_data_create_16(ovector_count, NULL);
+        }
+        return m_matchdata;
+    }
+
+private:
+    pcre2_jit_stack_16 *m_jitstack;
+    pcre2_match_context_16 *m_mcontext;
+    pcre2_match_data_16 *m_matchdata;
+};
+
+static SPCREThreadData &ThreadData()
+{
+    static thread_local SPCREThreadData thread_data;
+    return thread_data;
+}
+
+
 SPCRE::SPCRE(const QString &patten)
 {
     m_pattern = patten;
     m_re = NULL;
-    m_matchdata = NULL;
-    m_mcontext = NULL;
-
-#ifndef PCRE_NO_JIT
-    m_jitstack = NULL;
-#endif
-
+    m_jit = false;
     m_captureSubpatternCount = 0;
     m_error = QString();
     m_errpos = -1;
@@ -56,23 +109,17 @@ SPCRE::SPCRE(const QString &patten)
     // Pattern is valid.
     if (m_re != NULL) {
         m_valid = true;
-        m_matchdata = pcre2_match_data_create_from_pattern_16(m_re, NULL);
 
-
-#ifndef PCRE_NO_JIT
-        int rc = pcre2_jit_compile_16(m_re, PCRE2_JIT_COMPLETE);
-        if (rc == 0) {
-            m_mcontext = pcre2_match_context_create_16(NULL);
-            m_jitstack = pcre2_jit_stack_create_16(32*1024, 1024*1024, NULL);
-            if (m_jitstack != NULL) {
-                pcre2_jit_stack_assign_16(m_mcontext, NULL, m_jitstack);
-            }
+        // If JIT is unavailable or fails for this pattern
+        // the interpreter is used instead
+        if (USE_PCRE_JIT) {
+            m_jit = (pcre2_jit_compile_16(m_re, PCRE2_JIT_COMPLETE) == 0);
         }
-#endif
 
-        // Store the number of capture patterns (pairs).
-        // pcre2_pattern_info_16(m_re, PCRE2_INFO_CAPTURECOUNT, &m_captureSubpatternCount);
-        m_captureSubpatternCount = pcre2_get_ovector_count_16(m_matchdata);
+        // Store the number of capture patterns (pairs) including the full match.
+        uint32_t capturecount = 0;
+        pcre2_pattern_info_16(m_re, PCRE2_INFO_CAPTURECOUNT, &capturecount);
+        m_captureSubpatternCount = capturecount + 1;
     }
     // Pattern is not valid.
     else {
@@ -95,22 +142,6 @@ SPCRE::~SPCRE()
         m_re = NULL;
     }
 
-    if (m_matchdata != NULL) {
-        pcre2_match_data_free_16(m_matchdata);
-        m_matchdata = NULL;
-    }
-
-#ifndef PCRE_NO_JIT
-    if (m_jitstack) {
-        pcre2_jit_stack_free_16(m_jitstack);
-        m_jitstack = NULL;
-    }
-    if (m_mcontext) {
-        pcre2_match_context_free_16(m_mcontext);
-        m_mcontext = NULL;
-    }
-#endif
-
 }
 
 bool SPCRE::isValid()
@@ -178,6 +209,7 @@ QList<SPCRE::MatchInfo> SPCRE::getEveryMatchInfo(const QString &text)
     int rc = 0;
 
     PCRE2_SIZE * ovector = NULL;
+    pcre2_match_data * matchdata = NULL;
 
     // Set the size of the array based on the number of capture subpatterns
     // if it does not exceed our maximum size.
@@ -195,12 +227,15 @@ QList<SPCRE::MatchInfo> SPCRE::getEveryMatchInfo(const QString &text)
     // Run until no matches are found.
     do {
 
-        rc = pcre2_match_16(m_re, text.utf16(), text.length(), last_offset[1], 0, m_matchdata, m_mcontext);
+        rc = match(text, last_offset[1], matchdata);
+        if (matchdata == NULL) {
+            break;
+        }
 
-        // NOTE: until a call to pcre2_match_16 happens even through m_matchdata exists
+        // NOTE: until a call to pcre2_match_16 happens even through matchdata exists
         // and the ovector count is known, the pcre2_get_ovector_pointer returns a pointer
         // to invalid ovector data
-        ovector = pcre2_get_ovector_pointer_16(m_matchdata);
+        ovector = pcre2_get_ovector_pointer_16(matchdata);
 
         done = (ovector[1] == last_offset[1]) || (ovector[0] >= ovector[1]);
 
@@ -241,8 +276,12 @@ SPCRE::MatchInfo SPCRE::getFirstMatchInfo(const QString &text)
     // MSVC doesn't support it.
     // int *ovector = new int[ovector_size];
     // memset(ovector, 0, sizeof(int)*ovector_size);
-    rc = pcre2_match_16(m_re, text.utf16(), text.length(), 0, 0, m_matchdata, m_mcontext);
-    PCRE2_SIZE * ovector = pcre2_get_ovector_pointer_16(m_matchdata);
+    pcre2_match_data * matchdata = NULL;
+    rc = match(text, 0, matchdata);
+    if (matchdata == NULL) {
+        return match_info;
+    }
+    PCRE2_SIZE * ovector = pcre2_get_ovector_pointer_16(matchdata);
 
     if (rc >= 0 && ovector[0] != ovector[1]) {
         match_info = generateMatchInfo(ovector, ovector_count);
@@ -295,6 +334,22 @@ bool SPCRE::functionReplaceText(const QString &text, const QList<std::pair<int,
     return true;
 }
 
+int SPCRE::match(const QString &text, PCRE2_SIZE start_offset, pcre2_match_data *&matchdata)
+{
+    SPCREThreadData &thread_data = ThreadData();
+    matchdata = thread_data.matchData(m_captureSubpatternCount);
+    if (matchdata == NULL) {
+        return PCRE2_ERROR_NOMEMORY;
+    }
+    int rc = pcre2_match_16(m_re, text.utf16(), text.length(), start_offset, 0, matchdata, thread_data.matchContext());
+
+    // A pattern that exhausts the JIT stack may still succeed in the interpreter
+    if (m_jit && (rc == PCRE2_ERROR_JIT_STACKLIMIT)) {
+        rc = pcre2_match_16(m_re, text.utf16(), text.length(), start_offset, PCRE2_NO_JIT, matchdata, thread_data.matchContext());
+    }
+    return rc;
+}
+
 SPCRE::MatchInfo SPCRE::generateMatchInfo(PCRE2_SIZE* ovector, int capture_pattern_count)
 {
     MatchInfo match_info;
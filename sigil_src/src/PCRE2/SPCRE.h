@@ -154,6 +154,14 @@ public:
 private:
     MatchInfo generateMatchInfo(PCRE2_SIZE* ovector, int ovector_count);
 
+    /**
+     * Runs a single match using the calling thread's own match data
+     * so that one SPCRE may be shared across threads.
+     *
+     * @return The pcre2_match return code.
+     */
+    int match(const QString &text, PCRE2_SIZE start_offset, pcre2_match_data *&matchdata);
+
     // Store if the pattern is valid.
     bool m_valid;
 
@@ -167,18 +175,11 @@ private:
     // The compiled regular expression.
     pcre2_code *m_re;
 
-    // The place to store match data results.
-    pcre2_match_data *m_matchdata;
-
     // The number of capture subpatterns with the expression.
     int m_captureSubpatternCount;
 
-    // The place to store match context info such as JIT
-    pcre2_match_context * m_mcontext;
-
-#ifndef PCRE_NO_JIT
-    pcre2_jit_stack* m_jitstack;
-#endif
+    // Store if the pattern was successfully JIT compiled.
+    bool m_jit;
 
 };
 
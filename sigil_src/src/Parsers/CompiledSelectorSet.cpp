@@ -0,0 +1,172 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "Query/CParser.h"
+#include "Query/CSelector.h"
+#include "Parsers/CompiledSelectorSet.h"
+
+CompiledSelectorSet::CompiledSelectorSet()
+    : m_ByTag(GUMBO_TAG_LAST + 1),
+      m_Valid(0)
+{
+}
+
+
+CompiledSelectorSet::~CompiledSelectorSet()
+{
+    for (CSelector *sel : m_Selectors) {
+        if (sel) sel->release();
+    }
+}
+
+
+int CompiledSelectorSet::Add(const QString &selector_text)
+{
+    int index = static_cast<int>(m_Selectors.size());
+    CSelector *sel = NULL;
+    // parsing any selector can throw exceptions, a NULL entry marks the failure
+    try {
+        sel = CParser::create(selector_text.toStdString());
+    } catch(const std::runtime_error &e) {
+        std::cout << "***Query Parser Error***: " << e.what() << std::endl;
+        sel = NULL;
+    }
+    m_Selectors.push_back(sel);
+    if (!sel) return index;
+
+    m_Valid++;
+    std::string value;
+    GumboTag tag = GumboTag(0);
+    switch (sel->rightmostKey(value, tag)) {
+        case CSelector::EIdKey:
+            m_ByID[value].push_back(index);
+            break;
+        case CSelector::EClassKey:
+            m_ByClass[value].push_back(index);
+            break;
+        case CSelector::ETagKey:
+            m_ByTag[tag].push_back(index);
+            break;
+        default:
+            m_Unkeyed.push_back(index);
+            break;
+    }
+    return index;
+}
+
+
+void CompiledSelectorSet::TestCandidates(const std::vector<int> &candidates, GumboNode *node,
+                                         std::vector<bool> &used, int &remaining) const
+{
+    for (int i : candidates) {
+        if (!used[i] && m_Selectors[i]->match(node)) {
+            used[i] = true;
+            remaining--;
+        }
+    }
+}
+
+
+// the keyed selectors can only match elements, and for those the id and
+// class attributes are found exactly the way CAttributeSelector does:
+// the first attribute with that name, class split on whitespace
+void CompiledSelectorSet::TestNode(GumboNode *node, std::vector<bool> &used, int &remaining) const
+{
+    TestCandidates(m_Unkeyed, node, used, remaining);
+    if (node->type != GUMBO_NODE_ELEMENT) return;
+
+    GumboElement *element = &node->v.element;
+    TestCandidates(m_ByTag[element->tag], node, used, remaining);
+    if (m_ByID.empty() && m_ByClass.empty()) return;
+
+    GumboAttribute *id_attr = NULL;
+    GumboAttribute *class_attr = NULL;
+    for (unsigned int i = 0; i < element->attributes.length; i++) {
+        GumboAttribute *attr = static_cast<GumboAttribute *>(element->attributes.data[i]);
+        if (!id_attr && (strcmp(attr->name, "id") == 0)) {
+            id_attr = attr;
+        } else if (!class_attr && (strcmp(attr->name, "class") == 0)) {
+            class_attr = attr;
+        }
+    }
+    if (id_attr && !m_ByID.empty()) {
+        std::unordered_map<std::string, std::vector<int> >::const_iterator it = m_ByID.find(id_attr->value);
+        if (it != m_ByID.end()) TestCandidates(it->second, node, used, remaining);
+    }
+    if (class_attr && !m_ByClass.empty()) {
+        const char *p = class_attr->value;
+        while (*p) {
+            size_t n = strcspn(p, " \t\r\n\f");
+            if (n > 0) {
+                std::unordered_map<std::string, std::vector<int> >::const_iterator it = m_ByClass.find(std::string(p, n));
+                if (it != m_ByClass.end()) TestCandidates(it->second, node, used, remaining);
+                p += n;
+            }
+            if (*p) p++;
+        }
+    }
+}
+
+
+// visits nodes exactly as CSelector::matchAll does, returns false
+// once every selector of every set is known to be used
+bool CompiledSelectorSet::WalkNode(GumboNode *node,
+                                   const QList<const CompiledSelectorSet *> &sets,
+                                   QList<std::vector<bool> > &used,
+                                   QList<int> &remaining,
+                                   int &total_remaining)
+{
+    for (int i = 0; i < sets.count(); i++) {
+        int before = remaining[i];
+        if (before == 0) continue;
+        sets.at(i)->TestNode(node, used[i], remaining[i]);
+        total_remaining -= before - remaining[i];
+    }
+    if (total_remaining == 0) return false;
+    if (node->type != GUMBO_NODE_ELEMENT) return true;
+
+    for (unsigned int i = 0; i < node->v.element.children.length; i++) {
+        GumboNode *child = static_cast<GumboNode *>(node->v.element.children.data[i]);
+        if (!WalkNode(child, sets, used, remaining, total_remaining)) return false;
+    }
+    return true;
+}
+
+
+void CompiledSelectorSet::FindUsed(GumboNode *root,
+                                   const QList<const CompiledSelectorSet *> &sets,
+                                   QList<std::vector<bool> > &used)
+{
+    QList<int> remaining;
+    int total_remaining = 0;
+    used.clear();
+    foreach(const CompiledSelectorSet *set, sets) {
+        used.append(std::vector<bool>(set->Count(), false));
+        remaining.append(set->m_Valid);
+        total_remaining += set->m_Valid;
+    }
+    if (!root || (total_remaining == 0)) return;
+    WalkNode(root, sets, used, remaining, total_remaining);
+}
@@ -0,0 +1,95 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef COMPILEDSELECTORSET_H
+#define COMPILEDSELECTORSET_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <QString>
+#include <QList>
+
+#include "gumbo.h"
+
+class CSelector;
+
+// A list of css selectors each parsed only once by the Query CParser and
+// bucketed by the id, class, or tag their rightmost compound selector
+// requires, the way browser style engines do.
+//
+// FindUsed then walks a gumbo tree just once, testing each node only
+// against the selectors keyed by its own id, classes, and tag (and those
+// with no key at all).  A selector is reported as used exactly when
+// CSelection(root).find() of its text would have found a node.
+//
+// Once built a set is only read, so one set may be shared by many threads.
+
+class CompiledSelectorSet
+{
+public:
+
+    CompiledSelectorSet();
+    ~CompiledSelectorSet();
+
+    // parses and adds a selector, returning its index in this set
+    int Add(const QString &selector_text);
+
+    int Count() const { return static_cast<int>(m_Selectors.size()); }
+
+    // true if the Query parser could not parse the selector at index
+    bool ParseError(int index) const { return m_Selectors.at(index) == NULL; }
+
+    /**
+     * Marks used[i][j] for every selector j of sets[i] that matches at least
+     * one node of the tree at root.  Each used list is resized to the
+     * Count() of its set.  Selectors with parse errors are never marked.
+     */
+    static void FindUsed(GumboNode *root,
+                         const QList<const CompiledSelectorSet *> &sets,
+                         QList<std::vector<bool> > &used);
+
+private:
+
+    CompiledSelectorSet(const CompiledSelectorSet &);
+    CompiledSelectorSet &operator=(const CompiledSelectorSet &);
+
+    void TestCandidates(const std::vector<int> &candidates, GumboNode *node,
+                        std::vector<bool> &used, int &remaining) const;
+
+    void TestNode(GumboNode *node, std::vector<bool> &used, int &remaining) const;
+
+    static bool WalkNode(GumboNode *node,
+                         const QList<const CompiledSelectorSet *> &sets,
+                         QList<std::vector<bool> > &used,
+                         QList<int> &remaining,
+                         int &total_remaining);
+
+    std::vector<CSelector *> m_Selectors;
+    std::unordered_map<std::string, std::vector<int> > m_ByID;
+    std::unordered_map<std::string, std::vector<int> > m_ByClass;
+    std::vector<std::vector<int> > m_ByTag;
+    std::vector<int> m_Unkeyed;
+    int m_Valid;
+};
+
+#endif // COMPILEDSELECTORSET_H
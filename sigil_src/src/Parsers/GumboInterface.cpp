@@ -19,13 +19,11 @@
 **
 *************************************************************************/
 
+#include <cstring>
+
 #include <QString>
 #include <QStringList>
-#include <QRegularExpression>
-#include <QRegularExpressionMatch>
-#include <QDir>
 #include <QUrl>
-#include <QFileInfo>
 // #include <QDebug>
 
 #include "Misc/Utility.h"
@@ -35,6 +33,9 @@
 #include "string_buffer.h"
 #include "error.h"
 
+// each parse takes its memory from its own arena unless told otherwise
+static const bool USE_GUMBO_ARENA = !qEnvironmentVariableIsSet("SIGIL_DISABLE_GUMBO_ARENA");
+
 static std::unordered_set<std::string> nonbreaking_inline  = { 
     "a","abbr","acronym","b","bdo","big","br","button","cite","code","del",
     "dfn","em","font","i","image","img","input","ins","kbd","label","map",
@@ -124,13 +125,11 @@ GumboInterface::GumboInterface(const QString &source, const QString &version)
     : m_source(source),
       m_output(NULL),
       m_utf8src(""),
-      m_sourceupdates(EmptyHash),
+      m_sourcerewriter(EmptyHash),
+      m_stylerewriter(EmptyHash),
       m_newcsslinks(""),
-      m_currentbkpath(""),
-      m_currentdir(""),
       m_newbody(""),
-      m_version(version),
-      m_newbookpath("")
+      m_version(version)
 {
 }
 
@@ -139,13 +138,25 @@ GumboInterface::GumboInterface(const QString &source, const QString &version, co
     : m_source(source),
       m_output(NULL),
       m_utf8src(""),
-      m_sourceupdates(source_updates),
+      m_sourcerewriter(source_updates),
+      m_stylerewriter(source_updates),
       m_newcsslinks(""),
-      m_currentbkpath(""),
-      m_currentdir(""),
       m_newbody(""),
-      m_version(version),
-      m_newbookpath("")
+      m_version(version)
+{
+}
+
+
+GumboInterface::GumboInterface(const QString &source, const QString &version, const QHash<QString,QString> & source_updates,
+                               const QHash<QString,QString> & style_updates)
+    : m_source(source),
+      m_output(NULL),
+      m_utf8src(""),
+      m_sourcerewriter(source_updates),
+      m_stylerewriter(style_updates),
+      m_newcsslinks(""),
+      m_newbody(""),
+      m_version(version)
 {
 }
 
@@ -184,6 +195,7 @@ void GumboInterface::parse()
         myoptions.stop_on_first_error = false;
         myoptions.max_tree_depth = 400;
         myoptions.max_errors = 50;
+        myoptions.use_arena = USE_GUMBO_ARENA;
 
         // GumboInterface::m_mutex.lock();
         m_output = gumbo_parse_with_options(&myoptions, m_utf8src.data(), m_utf8src.length());
@@ -208,6 +220,7 @@ void GumboInterface::parse_fragment()
         myoptions.stop_on_first_error = false;
         myoptions.max_tree_depth = 400;
         myoptions.max_errors = 50;
+        myoptions.use_arena = USE_GUMBO_ARENA;
 
         m_utf8src = m_source.toStdString();
         m_output = gumbo_parse_fragment(&myoptions, m_utf8src.data(), m_utf8src.length(),
@@ -324,9 +337,7 @@ QStringList GumboInterface::get_all_properties()
 QString GumboInterface::perform_source_updates(const QString& my_current_book_relpath,
                                                const QString& newbookpath)
 {
-    m_currentbkpath = my_current_book_relpath;
-    m_currentdir = QFileInfo(m_currentbkpath).dir().path();
-    m_newbookpath = newbookpath;
+    m_sourcerewriter.SetPaths(my_current_book_relpath, newbookpath);
     QString result = "";
     if (!m_source.isEmpty()) {
         if (m_output == NULL) {
@@ -344,9 +355,7 @@ QString GumboInterface::perform_source_updates(const QString& my_current_book_re
 QString GumboInterface::perform_style_updates(const QString& my_current_book_relpath,
                                               const QString& newbookpath)
 {
-    m_currentbkpath = my_current_book_relpath;
-    m_currentdir = QFileInfo(m_currentbkpath).dir().path();
-    m_newbookpath = newbookpath;
+    m_stylerewriter.SetPaths(my_current_book_relpath, newbookpath);
     
     QString result = "";
     if (!m_source.isEmpty()) {
@@ -362,6 +371,28 @@ QString GumboInterface::perform_style_updates(const QString& my_current_book_rel
 }
 
 
+// rewrites href/src attributes using the source updates and inline style
+// and style element urls using the style updates in one serialization
+QString GumboInterface::perform_source_and_style_updates(const QString& my_current_book_relpath,
+                                                         const QString& newbookpath)
+{
+    m_sourcerewriter.SetPaths(my_current_book_relpath, newbookpath);
+    m_stylerewriter.SetPaths(my_current_book_relpath, newbookpath);
+
+    QString result = "";
+    if (!m_source.isEmpty()) {
+        if (m_output == NULL) {
+            parse();
+        }
+        enum UpdateTypes doupdates = static_cast<UpdateTypes>(SourceUpdates | StyleUpdates);
+        std::string utf8out = serialize(m_output->document, doupdates);
+        rtrim(utf8out);
+        result =  "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n" + QString::fromStdString(utf8out);
+    }
+    return result;
+}
+
+
 QString GumboInterface::perform_link_updates(const QString& newcsslinks)
 {
     m_newcsslinks = newcsslinks.toStdString();
@@ -638,6 +669,7 @@ QList<GumboWellFormedError> GumboInterface::error_check()
     myoptions.stop_on_first_error = false;
     myoptions.max_tree_depth = 400;
     myoptions.max_errors = -1;
+    myoptions.use_arena = USE_GUMBO_ARENA;
 
     if (!m_source.isEmpty() && (m_output == NULL)) {
 
@@ -697,6 +729,7 @@ QList<GumboWellFormedError> GumboInterface::fragment_error_check()
     myoptions.stop_on_first_error = false;
     myoptions.max_tree_depth = 400;
     myoptions.max_errors = -1;
+    myoptions.use_arena = USE_GUMBO_ARENA;
 
     if (!m_source.isEmpty() && (m_output == NULL)) {
         m_utf8src = m_source.toStdString();
@@ -922,6 +955,18 @@ void GumboInterface::rtrim(std::string &s)
 }
 
 
+// rtrim only the part of s at or after start
+void GumboInterface::rtrim_from(std::string &s, size_t start)
+{
+    size_t pos = s.find_last_not_of(" \n\r\t\v\f");
+    if ((pos == std::string::npos) || (pos < start)) {
+        s.resize(start);
+    } else {
+        s.resize(pos + 1);
+    }
+}
+
+
 void GumboInterface::ltrim(std::string &s)
 {
     s.erase(0,s.find_first_not_of(" \n\r\t\v\f"));
@@ -977,113 +1022,56 @@ void GumboInterface::replace_all(std::string &s, const char * s1, const char * s
 }
 
 
-std::string GumboInterface::update_attribute_value(const std::string &attvalue)
+// escape &, <, > and the attribute quote character (if any)
+// in a single scan appending the result to out
+void GumboInterface::append_xml_entities(std::string &out, const char * text, size_t len, char quote)
 {
-    std::string result = attvalue;
-    if (attvalue.find(":") != std::string::npos) return result;
-    bool has_fragment = attvalue.find("#") != std::string::npos;
-    QUrl href(QString::fromStdString(attvalue));
-    QString attpath = href.path();
-    // handle purely local hrefs here as they do not need to be updated at all
-    if (attpath.isEmpty() && has_fragment) return result;
-    QString fragment;
-    if (has_fragment) {
-        fragment = href.fragment();
-    }    
-
-    QString dest_oldbkpath;
-    if (attpath.isEmpty()) {
-        dest_oldbkpath = m_currentbkpath;
-    } else {
-        dest_oldbkpath = Utility::buildBookPath(attpath, m_currentdir);
-    }
-    
-    // note destination may not have moved but we still need to update
-    // the link since we may have moved
-    QString dest_newbkpath = m_sourceupdates.value(dest_oldbkpath, dest_oldbkpath);
-    if (!dest_newbkpath.isEmpty() && !m_newbookpath.isEmpty()) {
-        QString new_path = Utility::buildRelativePath(m_newbookpath, dest_newbkpath);
-        QString new_href(Utility::URLEncodePath(new_path));
-        if (has_fragment) {
-            new_href.append("#");
-            new_href.append(QUrl::toPercentEncoding(fragment));
+    size_t start = 0;
+    for (size_t i = 0; i < len; i++) {
+        const char * entity = NULL;
+        switch (text[i]) {
+            case '&':
+                entity = "&amp;";
+                break;
+            case '<':
+                entity = "&lt;";
+                break;
+            case '>':
+                entity = "&gt;";
+                break;
+            case '"':
+                if (quote == '"') entity = "&quot;";
+                break;
+            case '\'':
+                if (quote == '\'') entity = "&apos;";
+                break;
+            default:
+                break;
         }
-
-        // if empty then internal link to the top (which is best here?)                                
-        if (new_href.isEmpty()) new_href = QFileInfo(dest_newbkpath).fileName();
-        // if (new_href.isEmpty()) new_href="#";                                                          
-
-        result =  new_href.toStdString();
-    }
-    return result;
-}
-
-
-std::string GumboInterface::update_style_urls(const std::string &source)
-{
-    QString result = QString::fromStdString(source);
-    // Now parse the text once looking urls and replacing them where needed
-    QRegularExpression reference(
-        "(?:(?:src|background|background-image|list-style|list-style-image|border-image|border-image-source|content)\\s*:|@import)\\s*"
-        "[^;\\}\\(\"']*"
-        "(?:"
-        "url\\([\"']?([^\\(\\)\"']*)[\"']?\\)"
-        "|"
-        "[\"']([^\\(\\)\"']*)[\"']"
-        ")");
-    int start_index = 0;
-    QRegularExpressionMatch mo = reference.match(result, start_index);
-    do {
-        for (int i = 1; i < reference.captureCount(); ++i) {
-            if (mo.captured(i).trimmed().isEmpty()) {
-                continue;
-            }
-            if (mo.captured(i).indexOf(":") != -1) continue;
-            QString apath = Utility::URLDecodePath(mo.captured(i));
-            QString dest_oldbkpath;
-            if (apath.isEmpty()) {
-              dest_oldbkpath = m_currentbkpath;
-            } else {
-              dest_oldbkpath = Utility::buildBookPath(apath, m_currentdir);
-            }
-            // note destination may not have moved but we still need to update
-            // the link
-            QString dest_newbkpath = m_sourceupdates.value(dest_oldbkpath, dest_oldbkpath);
-            if (!dest_newbkpath.isEmpty() && !m_newbookpath.isEmpty()) {
-                QString new_href = Utility::buildRelativePath(m_newbookpath, dest_newbkpath);
-                if (new_href.isEmpty()) new_href = QFileInfo(dest_newbkpath).fileName();
-                new_href = Utility::URLEncodePath(new_href);
-                result.replace(mo.capturedStart(i), mo.capturedLength(i), new_href);
-            }
+        if (entity) {
+            out.append(text + start, i - start);
+            out.append(entity);
+            start = i + 1;
         }
-        start_index = mo.capturedEnd();
-        mo = reference.match(result, start_index);
-    } while (mo.hasMatch());
-
-    return result.toStdString();
+    }
+    out.append(text + start, len - start);
 }
 
 
-
 std::string GumboInterface::substitute_xml_entities_into_text(const std::string &text)
 {
-    std::string result = text;
-    // replacing & must come first 
-    replace_all(result, "&", "&amp;");
-    replace_all(result, "<", "&lt;");
-    replace_all(result, ">", "&gt;");
+    std::string result;
+    result.reserve(text.length());
+    append_xml_entities(result, text.data(), text.length());
     return result;
 }
 
 
 std::string GumboInterface::substitute_xml_entities_into_attributes(char quote, const std::string &text)
 {
-    std::string result = substitute_xml_entities_into_text(text);
-    if (quote == '"') {
-        replace_all(result,"\"","&quot;");
-    } else if (quote == '\'') {
-        replace_all(result,"'","&apos;");
-    }
+    std::string result;
+    result.reserve(text.length());
+    append_xml_entities(result, text.data(), text.length(), quote);
     return result;
 }
 
@@ -1173,23 +1161,22 @@ std::string GumboInterface::get_attribute_name(GumboAttribute * at)
 }
 
 
-std::string GumboInterface::build_attributes(GumboAttribute * at, bool no_entities, 
-                                             bool run_src_updates, bool run_style_updates)
+void GumboInterface::build_attributes(std::string &out, GumboAttribute * at, bool no_entities, 
+                                      bool run_src_updates, bool run_style_updates)
 {
-    std::string atts = " ";
-    std::string name = get_attribute_name(at);
+    out.append(" ");
     std::string local_name = at->name;
-    atts.append(name);
+    out.append(get_attribute_name(at));
     std::string attvalue = at->value;
 
     if (run_src_updates && (local_name == aHREF || local_name == aSRC || 
                             local_name == aPOSTER || local_name == aDATA ||
                             local_name == aSRCSET || local_name == aALTIMG)) {
-        attvalue = update_attribute_value(attvalue);
+        attvalue = m_sourcerewriter.UpdateAttributeValue(attvalue);
     }
 
     if (run_style_updates && (local_name == "style")) {
-        attvalue = update_style_urls(attvalue);
+        attvalue = m_stylerewriter.UpdateStyleUrls(attvalue);
     }
 
     // we handle empty attribute values like so: alt=""
@@ -1210,23 +1197,44 @@ std::string GumboInterface::build_attributes(GumboAttribute * at, bool no_entiti
         }
     }
 
-    atts.append("=");
-    atts.append(qs);
+    out.append("=");
+    out.append(qs);
     if (no_entities) {
-        atts.append(attvalue);
+        out.append(attvalue);
     } else {
-        atts.append(substitute_xml_entities_into_attributes(quote, attvalue));
+        append_xml_entities(out, attvalue.data(), attvalue.length(), quote);
     }
-    atts.append(qs);
-    return atts;
+    out.append(qs);
 }
 
 
 // serialize children of a node
-// may be invoked recursively
 
 std::string GumboInterface::serialize_contents(GumboNode* node, enum UpdateTypes doupdates) {
-    std::string contents        = "";
+    std::string contents;
+    serialize_contents_to(node, doupdates, contents);
+    return contents;
+}
+
+
+// serialize a GumboNode back to html/xhtml
+
+std::string GumboInterface::serialize(GumboNode* node, enum UpdateTypes doupdates) {
+    std::string results;
+    // the output is normally close in size to the source so
+    // allocate once with some headroom for added entities
+    results.reserve(m_utf8src.length() + m_utf8src.length() / 8 + 1024);
+    serialize_to(node, doupdates, results);
+    return results;
+}
+
+
+// serialize children of a node appending to out
+// may be invoked recursively
+
+void GumboInterface::serialize_contents_to(GumboNode* node, enum UpdateTypes doupdates, std::string &out) {
+    // everything this node adds to out starts here
+    size_t contents_start       = out.length();
     std::string tagname         = get_tag_name(node);
     bool no_entity_substitution = in_set(no_entity_sub, tagname);
     bool keep_whitespace        = in_set(preserve_whitespace, tagname);
@@ -1243,32 +1251,33 @@ std::string GumboInterface::serialize_contents(GumboNode* node, enum UpdateTypes
         GumboNode* child = static_cast<GumboNode*> (children->data[i]);
 
         if (child->type == GUMBO_NODE_TEXT) {
-            std::string text;
+            const char * text = child->v.text.text;
+            size_t len = strlen(text);
+            if (injected_newline && (len > 0) && (text[0] == '\n')) {
+                text++;
+                len--;
+            }
+            injected_newline = false;
             if (no_entity_substitution) {
-                text = std::string(child->v.text.text);
+                out.append(text, len);
             } else {
-                text = substitute_xml_entities_into_text(std::string(child->v.text.text));
+                append_xml_entities(out, text, len);
             }
-            if (injected_newline && !text.empty() && (text.at(0) == '\n')) text.erase(0,1);
-            injected_newline = false;
-            contents.append(text);
 
         } else if (child->type == GUMBO_NODE_ELEMENT || child->type == GUMBO_NODE_TEMPLATE) {
-            std::string tagstring = serialize(child, doupdates);
-            // empty tagstring means this tag node is being removed
-            if (tagstring.empty()) {
+            // nothing written means this tag node is being removed
+            if (!serialize_to(child, doupdates, out)) {
                 // strip off trailing whitespace from predecessor tag
-                rtrim(contents);
-                contents.append("\n"); 
+                rtrim_from(out, contents_start);
+                out.append("\n"); 
                 // strip out any associated newline in trailing whitespace node
                 injected_newline = true;
             } else {
-                contents.append(tagstring);
                 injected_newline = false;
                 std::string childname = get_tag_name(child);
                 if (in_head_without_title && (childname == "title")) in_head_without_title = false;
                 if (!is_inline && !keep_whitespace && !in_set(nonbreaking_inline,childname) && is_structural) {
-                    contents.append("\n");
+                    out.append("\n");
                     injected_newline = true;
                 }
             }
@@ -1280,15 +1289,19 @@ std::string GumboInterface::serialize_contents(GumboNode* node, enum UpdateTypes
                 newlinetrim(wspace);
                 injected_newline = false;
             }
-            contents.append(wspace);
+            out.append(wspace);
             injected_newline = false;
 
         } else if (child->type == GUMBO_NODE_CDATA) {
-            contents.append("<![CDATA[" + std::string(child->v.text.text) + "]]>");
+            out.append("<![CDATA[");
+            out.append(child->v.text.text);
+            out.append("]]>");
             injected_newline = false;
 
         } else if (child->type == GUMBO_NODE_COMMENT) {
-            contents.append("<!--" + std::string(child->v.text.text) + "-->");
+            out.append("<!--");
+            out.append(child->v.text.text);
+            out.append("-->");
  
         } else {
             fprintf(stderr, "unknown element of type: %d\n", child->type); 
@@ -1296,38 +1309,36 @@ std::string GumboInterface::serialize_contents(GumboNode* node, enum UpdateTypes
         }
 
     }
-    if (in_head_without_title) contents.append("<title></title>");
-    return contents;
+    if (in_head_without_title) out.append("<title></title>");
 }
 
 
-// serialize a GumboNode back to html/xhtml
+// serialize a GumboNode back to html/xhtml appending to out
+// returns false if the node is being removed and nothing was written
 // may be invoked recursively
 
-std::string GumboInterface::serialize(GumboNode* node, enum UpdateTypes doupdates) {
+bool GumboInterface::serialize_to(GumboNode* node, enum UpdateTypes doupdates, std::string &out) {
     // special case the document node
     if (node->type == GUMBO_NODE_DOCUMENT) {
-        std::string results = build_doctype(node);
-        results.append(serialize_contents(node, doupdates));
-        return results;
+        out.append(build_doctype(node));
+        serialize_contents_to(node, doupdates, out);
+        return true;
     }
 
-    std::string close = "";
-    std::string closeTag = "";
-    std::string atts = "";
     std::string tagname            = get_tag_name(node);
     bool need_special_handling     = in_set(special_handling, tagname);
     bool is_void_tag               = in_set(void_tags, tagname);
     bool no_entity_substitution    = in_set(no_entity_sub, tagname);
     bool is_href_src_tag           = in_set(href_src_tags, tagname);
     bool in_xml_ns                 = node->v.element.tag_namespace != GUMBO_NAMESPACE_HTML;
+    bool parent_is_head            = (node->parent->type == GUMBO_NODE_ELEMENT) &&
+                                     (node->parent->v.element.tag == GUMBO_TAG_HEAD);
     // bool is_inline                 = in_set(nonbreaking_inline, tagname);
     bool is_jslink = false;
 
 
     // handle special case of stylesheet link missing type attribute
-    if ((tagname == "link") && (node->parent->type == GUMBO_NODE_ELEMENT) && 
-        (node->parent->v.element.tag == GUMBO_TAG_HEAD)) {
+    if ((tagname == "link") && parent_is_head) {
         const GumboVector * attribs = &node->v.element.attributes;
         GumboAttribute* relatt = gumbo_get_attribute(attribs, "rel");
         GumboAttribute* typeatt = gumbo_get_attribute(attribs, "type");
@@ -1339,16 +1350,10 @@ std::string GumboInterface::serialize(GumboNode* node, enum UpdateTypes doupdate
         }
     }
     
-    // build attr string  
     GumboVector * attribs = &node->v.element.attributes;
-    for (unsigned int i=0; i< attribs->length; ++i) {
-        GumboAttribute* at = static_cast<GumboAttribute*>(attribs->data[i]);
-        atts.append(build_attributes(at, no_entity_substitution, ((doupdates & SourceUpdates) && is_href_src_tag), (doupdates & StyleUpdates)));
-    }
 
     if (tagname == "script") {
-        if ((node->parent->type == GUMBO_NODE_ELEMENT) && 
-            (node->parent->v.element.tag == GUMBO_TAG_HEAD)) {
+        if (parent_is_head) {
             GumboAttribute* srcatt = gumbo_get_attribute(attribs, "src");
             GumboAttribute* typeatt = gumbo_get_attribute(attribs, "type");
             if (srcatt && typeatt) {
@@ -1362,79 +1367,90 @@ std::string GumboInterface::serialize(GumboNode* node, enum UpdateTypes doupdate
             }
         }
     }
-    
+
+    // links and javascripts being replaced are removed
+    if ((doupdates & LinkUpdates) && (tagname == "link") && parent_is_head) {
+        return false;
+    }
+
+    if ((doupdates & JavascriptUpdates) && is_jslink) {
+        return false;
+    }
+
+    // build start tag with attr string  
+    out.append("<");
+    out.append(tagname);
+    size_t atts_start = out.length();
+    for (unsigned int i=0; i< attribs->length; ++i) {
+        GumboAttribute* at = static_cast<GumboAttribute*>(attribs->data[i]);
+        build_attributes(out, at, no_entity_substitution, ((doupdates & SourceUpdates) && is_href_src_tag), (doupdates & StyleUpdates));
+    }
+
     // Make sure that the xmlns attribute exists as an html tag attribute
     if (tagname == "html") {
-        if (atts.find("xmlns=") == std::string::npos) {
-            atts.append(" xmlns=\"http://www.w3.org/1999/xhtml\"");
+        if (out.find("xmlns=", atts_start) == std::string::npos) {
+            out.append(" xmlns=\"http://www.w3.org/1999/xhtml\"");
         }
         if (m_version.startsWith('3')) {
-            if (atts.find("xmlns:epub") == std::string::npos) {
-                atts.append(" xmlns:epub=\"http://www.idpf.org/2007/ops\"");
+            if (out.find("xmlns:epub", atts_start) == std::string::npos) {
+                out.append(" xmlns:epub=\"http://www.idpf.org/2007/ops\"");
             }
         }
     }
 
-    // determine contents
-    std::string contents;
+    // the start tag is closed now and made self-closing later if need be
+    size_t close_pos = out.length();
+    out.append(">");
+    if (need_special_handling) out.append("\n");
 
+    // determine contents
+    size_t contents_start = out.length();
     if ((tagname == "body") && (doupdates & BodyUpdates)) {
-        contents = m_newbody;
+        out.append(m_newbody);
     } else {
         // serialize your contents
-        contents = serialize_contents(node, doupdates);
+        serialize_contents_to(node, doupdates, out);
     }
 
     // determine closing tag type
-    std::string testcontents = contents;
-    ltrim(testcontents);
-    if (is_void_tag || (in_xml_ns && testcontents.empty())) {
-        close = "/";
-    } else {
-        closeTag = "</" + tagname + ">";
-    }
+    bool blank_contents = out.find_first_not_of(" \n\r\t\v\f", contents_start) == std::string::npos;
+    bool self_closing = is_void_tag || (in_xml_ns && blank_contents);
 
-    if ((doupdates & StyleUpdates) && (tagname == "style") && 
-        (node->parent->type == GUMBO_NODE_ELEMENT) && 
-        (node->parent->v.element.tag == GUMBO_TAG_HEAD)) {
-        contents = update_style_urls(contents);
+    if ((doupdates & StyleUpdates) && (tagname == "style") && parent_is_head) {
+        std::string contents = m_stylerewriter.UpdateStyleUrls(out.substr(contents_start));
+        out.resize(contents_start);
+        out.append(contents);
     }
 
     if (need_special_handling) {
-        ltrimnewlines(contents);
-        rtrim(contents);
-        contents.append("\n");
-    }
-
-    // build results
-    std::string results;
-
-    if ((doupdates & LinkUpdates) && (tagname == "link") && 
-        (node->parent->type == GUMBO_NODE_ELEMENT) && 
-        (node->parent->v.element.tag == GUMBO_TAG_HEAD)) {
-        return "";
+        size_t pos = out.find_first_not_of("\n\r", contents_start);
+        if (pos == std::string::npos) pos = out.length();
+        out.erase(contents_start, pos - contents_start);
+        rtrim_from(out, contents_start);
+        out.append("\n");
     }
 
-    if ((doupdates & JavascriptUpdates) && is_jslink) {
-        return "";
+    // only blank contents or none at all follow a self-closing tag
+    // so this insert is cheap
+    if (self_closing) {
+        out.insert(close_pos, "/");
     }
 
-    results.append("<"+tagname+atts+close+">");
-    
-    if (need_special_handling) results.append("\n");
-    results.append(contents);
-
     if ((doupdates & LinkUpdates) && (tagname == "head")) {
-        results.append(m_newcsslinks);
+        out.append(m_newcsslinks);
     }
 
     if ((doupdates & JavascriptUpdates) && (tagname == "head")) {
-        results.append(m_newjslinks);
+        out.append(m_newjslinks);
     }
 
-    results.append(closeTag);
-    if (need_special_handling) results.append("\n");
-    return results;
+    if (!self_closing) {
+        out.append("</");
+        out.append(tagname);
+        out.append(">");
+    }
+    if (need_special_handling) out.append("\n");
+    return true;
 }
 
 
@@ -1590,7 +1606,7 @@ std::string GumboInterface::prettyprint(GumboNode* node, int lvl, const std::str
     const GumboVector * attribs = &node->v.element.attributes;
     for (unsigned int i=0; i< attribs->length; ++i) {
         GumboAttribute* at = static_cast<GumboAttribute*>(attribs->data[i]);
-        atts.append(build_attributes(at, no_entity_substitution));
+        build_attributes(atts, at, no_entity_substitution);
     }
 
     bool is_void_tag = in_set(void_tags, tagname);
@@ -31,6 +31,7 @@
 #include "gumbo_edit.h"
 
 #include "Query/CSelection.h"
+#include "Parsers/LinkRewriter.h"
 
 #include <QString>
 #include <QList>
@@ -50,6 +51,8 @@ public:
 
     GumboInterface(const QString &source, const QString &version);
     GumboInterface(const QString &source, const QString &version, const QHash<QString, QString> &source_updates);
+    GumboInterface(const QString &source, const QString &version, const QHash<QString, QString> &source_updates,
+                   const QHash<QString, QString> &style_updates);
     ~GumboInterface();
 
     void    parse();
@@ -89,6 +92,7 @@ public:
     // routines for updating while serializing (see SourceUpdates and AnchorUpdates
     QString perform_source_updates(const QString & my_current_book_relpath, const QString& newbookpath);
     QString perform_style_updates(const QString & my_current_book_relpath, const QString& newbookpath);
+    QString perform_source_and_style_updates(const QString & my_current_book_relpath, const QString& newbookpath);
     QString perform_link_updates(const QString & newlinks);
     QString perform_javascript_updates(const QString & newjavascripts);
     QString get_body_contents();
@@ -140,6 +144,11 @@ private:
 
     std::string serialize_contents(GumboNode* node, enum UpdateTypes doupdates = NoUpdates);
 
+    // streaming versions of the above that append to one output buffer
+    bool serialize_to(GumboNode* node, enum UpdateTypes doupdates, std::string &out);
+
+    void serialize_contents_to(GumboNode* node, enum UpdateTypes doupdates, std::string &out);
+
     std::string prettyprint(GumboNode* node, int lvl, const std::string indent_chars);
 
     std::string prettyprint_contents(GumboNode* node, int lvl, const std::string indent_chars);
@@ -148,20 +157,20 @@ private:
 
     std::string get_attribute_name(GumboAttribute * at);
 
-    std::string build_attributes(GumboAttribute * at, bool no_entities, bool run_src_updates = false, bool run_style_updates = false);
-
-    std::string update_attribute_value(const std::string &href);
-
-    std::string update_style_urls(const std::string& source);
+    void build_attributes(std::string &out, GumboAttribute * at, bool no_entities, bool run_src_updates = false, bool run_style_updates = false);
 
     std::string substitute_xml_entities_into_text(const std::string &text);
 
     std::string substitute_xml_entities_into_attributes(char quote, const std::string &text);
 
+    void append_xml_entities(std::string &out, const char * text, size_t len, char quote = '\0');
+
     bool in_set(std::unordered_set<std::string> &s, std::string &key);
 
     void rtrim(std::string &s);
 
+    void rtrim_from(std::string &s, size_t start);
+
     void ltrim(std::string &s);
 
     void ltrimnewlines(std::string &s);
@@ -178,14 +187,12 @@ private:
     QString                         m_source;
     GumboOutput*                    m_output;
     std::string                     m_utf8src;
-    const QHash<QString, QString> & m_sourceupdates;
+    LinkRewriter                    m_sourcerewriter;
+    LinkRewriter                    m_stylerewriter;
     std::string                     m_newcsslinks;
     std::string                     m_newjslinks;
-    QString                         m_currentbkpath;
-    QString                         m_currentdir;
     std::string                     m_newbody;
     QString                         m_version;
-    QString                         m_newbookpath;
     
 };
 
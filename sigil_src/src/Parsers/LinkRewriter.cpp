@@ -0,0 +1,202 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <QDir>
+#include <QUrl>
+#include <QFileInfo>
+#include <QStringView>
+#include <QRegularExpression>
+#include <QRegularExpressionMatch>
+
+#include "Misc/Utility.h"
+#include "Parsers/LinkRewriter.h"
+
+static const QRegularExpression STYLE_URL(
+    "(?:(?:src|background|background-image|list-style|list-style-image|border-image|border-image-source|content)\\s*:|@import)\\s*"
+    "[^;\\}\\(\"']*"
+    "(?:"
+    "url\\([\"']?([^\\(\\)\"']*)[\"']?\\)"
+    "|"
+    "[\"']([^\\(\\)\"']*)[\"']"
+    ")");
+
+
+LinkRewriter::LinkRewriter(const QHash<QString, QString> &updates)
+    : m_updates(updates),
+      m_currentbkpath(""),
+      m_currentdir(""),
+      m_newbookpath("")
+{
+}
+
+
+void LinkRewriter::SetPaths(const QString &currentbkpath, const QString &newbookpath)
+{
+    if ((currentbkpath != m_currentbkpath) || (newbookpath != m_newbookpath)) {
+        m_AttributePaths.clear();
+        m_StyleUrls.clear();
+    }
+    m_currentbkpath = currentbkpath;
+    m_currentdir = QFileInfo(m_currentbkpath).dir().path();
+    m_newbookpath = newbookpath;
+}
+
+
+std::string LinkRewriter::UpdateAttributeValue(const std::string &attvalue)
+{
+    if (attvalue.find(":") != std::string::npos) return attvalue;
+    size_t hashpos = attvalue.find("#");
+    bool has_fragment = hashpos != std::string::npos;
+    const ResolvedPath &rp = ResolveAttributePath(has_fragment ? attvalue.substr(0, hashpos) : attvalue);
+
+    // handle purely local hrefs here as they do not need to be updated at all
+    if (rp.empty_path && has_fragment) return attvalue;
+    if (!rp.update) return attvalue;
+
+    std::string result = rp.new_path;
+    if (has_fragment) {
+        result.append("#");
+        if (!AppendEncodedFragment(result, attvalue.data() + hashpos + 1, attvalue.length() - hashpos - 1)) {
+            QUrl href(QString::fromStdString(attvalue));
+            result.append(QUrl::toPercentEncoding(href.fragment()).toStdString());
+        }
+    }
+
+    // if empty then internal link to the top (which is best here?)
+    if (result.empty()) result = rp.filename;
+    return result;
+}
+
+
+std::string LinkRewriter::UpdateStyleUrls(const std::string &source)
+{
+    if (!MayContainStyleUrl(source)) return source;
+
+    QString text = QString::fromStdString(source);
+    QString result;
+    qsizetype last = 0;
+    QRegularExpressionMatch mo = STYLE_URL.match(text);
+    while (mo.hasMatch()) {
+        // only url() references are updated here
+        QString url = mo.captured(1);
+        if (!url.trimmed().isEmpty() && !url.contains(':')) {
+            QString new_href = ResolveStyleUrl(url);
+            if (!new_href.isNull()) {
+                result.append(QStringView(text).mid(last, mo.capturedStart(1) - last));
+                result.append(new_href);
+                last = mo.capturedEnd(1);
+            }
+        }
+        mo = STYLE_URL.match(text, mo.capturedEnd());
+    }
+    if (last == 0) return source;
+    result.append(QStringView(text).mid(last));
+    return result.toStdString();
+}
+
+
+// note destination may not have moved but we still need to update
+// the link since we may have moved
+const LinkRewriter::ResolvedPath &LinkRewriter::ResolveAttributePath(const std::string &rawpath)
+{
+    std::unordered_map<std::string, ResolvedPath>::const_iterator it = m_AttributePaths.find(rawpath);
+    if (it != m_AttributePaths.end()) return it->second;
+
+    ResolvedPath rp;
+    QUrl href(QString::fromStdString(rawpath));
+    QString attpath = href.path();
+    rp.empty_path = attpath.isEmpty();
+    rp.update = false;
+    QString dest_oldbkpath;
+    if (attpath.isEmpty()) {
+        dest_oldbkpath = m_currentbkpath;
+    } else {
+        dest_oldbkpath = Utility::buildBookPath(attpath, m_currentdir);
+    }
+    QString dest_newbkpath = m_updates.value(dest_oldbkpath, dest_oldbkpath);
+    if (!dest_newbkpath.isEmpty() && !m_newbookpath.isEmpty()) {
+        QString new_path = Utility::buildRelativePath(m_newbookpath, dest_newbkpath);
+        rp.update = true;
+        rp.new_path = Utility::URLEncodePath(new_path).toStdString();
+        rp.filename = QFileInfo(dest_newbkpath).fileName().toStdString();
+    }
+    return m_AttributePaths.emplace(rawpath, rp).first->second;
+}
+
+
+// returns a null QString if the url should be left alone
+QString LinkRewriter::ResolveStyleUrl(const QString &url)
+{
+    QHash<QString, QString>::const_iterator it = m_StyleUrls.constFind(url);
+    if (it != m_StyleUrls.constEnd()) return it.value();
+
+    QString new_href;
+    QString apath = Utility::URLDecodePath(url);
+    QString dest_oldbkpath;
+    if (apath.isEmpty()) {
+        dest_oldbkpath = m_currentbkpath;
+    } else {
+        dest_oldbkpath = Utility::buildBookPath(apath, m_currentdir);
+    }
+    QString dest_newbkpath = m_updates.value(dest_oldbkpath, dest_oldbkpath);
+    if (!dest_newbkpath.isEmpty() && !m_newbookpath.isEmpty()) {
+        new_href = Utility::buildRelativePath(m_newbookpath, dest_newbkpath);
+        if (new_href.isEmpty()) new_href = QFileInfo(dest_newbkpath).fileName();
+        new_href = Utility::URLEncodePath(new_href);
+    }
+    m_StyleUrls.insert(url, new_href);
+    return new_href;
+}
+
+
+// percent encode all but the unreserved characters of a fragment exactly as
+// QUrl::toPercentEncoding(QUrl(href).fragment()) would, returns false leaving
+// out unchanged for anything QUrl does not simply pass through: escapes (which
+// QUrl only partly decodes), control characters, '`', DEL and non-ascii
+bool LinkRewriter::AppendEncodedFragment(std::string &out, const char *frag, size_t len)
+{
+    static const char hexdigits[] = "0123456789ABCDEF";
+    size_t start = out.length();
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = frag[i];
+        if ((c < 0x20) || (c >= 0x7F) || (c == '%') || (c == '`')) {
+            out.resize(start);
+            return false;
+        }
+        if (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) ||
+            (c == '-') || (c == '.') || (c == '_') || (c == '~')) {
+            out.push_back(c);
+        } else {
+            out.push_back('%');
+            out.push_back(hexdigits[c >> 4]);
+            out.push_back(hexdigits[c & 0xF]);
+        }
+    }
+    return true;
+}
+
+
+// only url() references are ever rewritten so anything without one
+// can be skipped without converting it from utf-8 at all
+bool LinkRewriter::MayContainStyleUrl(const std::string &source)
+{
+    return source.find("url(") != std::string::npos;
+}
@@ -0,0 +1,82 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef LINKREWRITER_H
+#define LINKREWRITER_H
+
+#include <string>
+#include <unordered_map>
+#include <QString>
+#include <QHash>
+
+// Rewrites the links found in utf-8 attribute values and css style text
+// while serializing a file whose links (or itself) have been moved.
+//
+// Its patterns are compiled once, and the old to new relative href for
+// each link target is resolved only once for as long as the book path of
+// the file being updated (and its new book path) stay the same.
+
+class LinkRewriter
+{
+public:
+
+    LinkRewriter(const QHash<QString, QString> &updates);
+
+    /**
+     * Sets the book path of the file being updated and its new book path.
+     * Any memoized results are dropped if either one changes.
+     */
+    void SetPaths(const QString &currentbkpath, const QString &newbookpath);
+
+    // rewrites a single href, src, poster, data, etc attribute value
+    std::string UpdateAttributeValue(const std::string &attvalue);
+
+    // rewrites the urls of an inline style attribute or style element
+    std::string UpdateStyleUrls(const std::string &source);
+
+private:
+
+    struct ResolvedPath {
+        bool        empty_path;
+        bool        update;
+        std::string new_path;
+        std::string filename;
+    };
+
+    const ResolvedPath &ResolveAttributePath(const std::string &rawpath);
+
+    QString ResolveStyleUrl(const QString &url);
+
+    static bool AppendEncodedFragment(std::string &out, const char *frag, size_t len);
+
+    static bool MayContainStyleUrl(const std::string &source);
+
+    const QHash<QString, QString> &m_updates;
+    QString m_currentbkpath;
+    QString m_currentdir;
+    QString m_newbookpath;
+
+    std::unordered_map<std::string, ResolvedPath> m_AttributePaths;
+    QHash<QString, QString> m_StyleUrls;
+};
+
+#endif // LINKREWRITER_H
@@ -0,0 +1,694 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#include <QChar>
+#include <QByteArray>
+#include <QStringDecoder>
+#include <QRegularExpression>
+#include <QRegularExpressionMatch>
+#include <QXmlStreamReader>
+#include <QDebug>
+
+#include "Misc/Utility.h"
+#include "Parsers/NativeXMLProcessor.h"
+
+#define DBG if(0)
+
+static const QString OPF_MTYPE = "application/oebps-package+xml";
+static const QString OPF_NS    = "http://www.idpf.org/2007/opf";
+static const QString XML_NS    = "http://www.w3.org/XML/1998/namespace";
+
+// see _remove_xml_header() in xmlprocessor.py
+static const QRegularExpression XML_HEADER("<\\s*\\?xml\\s*[^\\?>]*\\?*>\\s*",
+                                           QRegularExpression::CaseInsensitiveOption |
+                                           QRegularExpression::UseUnicodePropertiesOption);
+
+// the standard prefixes sigil_bs4 forces onto known namespaces
+static const QHash<QString, QString> STD_PREFIXES = {
+    { "http://www.idpf.org/2007/opf",                             "opf"       },
+    { "http://purl.org/dc/elements/1.1/",                         "dc"        },
+    { "http://purl.org/dc/terms/",                                "dcterms"   },
+    { "http://id.loc.gov/vocabulary/",                            "marc"      },
+    { "http://www.idpf.org/vocab/rendition/#",                    "rendition" },
+    { "http://www.editeur/org/ONIX/book/codelists/current.html#", "onix"      },
+    { "http://www.idpf.org/epub/vocab/overlays/#",                "media"     },
+    { "http://www.idpf.org/2007/ops",                             "epub"      }
+};
+
+// opf tags Opf_Parser treats as containers
+static const QStringList OPF_PARENTS = QStringList() << "package" << "metadata" << "dc-metadata"
+                                                     << "x-metadata" << "manifest" << "spine"
+                                                     << "tours" << "guide" << "bindings";
+
+
+// returns the number of QChars used by the code point starting at pos
+static int CodePointAt(const QString &s, int pos, char32_t &cp)
+{
+    QChar c = s.at(pos);
+    if (c.isHighSurrogate() && (pos + 1 < s.length()) && s.at(pos + 1).isLowSurrogate()) {
+        cp = QChar::surrogateToUcs4(c, s.at(pos + 1));
+        return 2;
+    }
+    cp = c.unicode();
+    return 1;
+}
+
+
+// python's \w
+static bool IsWordChar(char32_t cp)
+{
+    return (cp == '_') || QChar::isLetterOrNumber(cp);
+}
+
+
+// python's str.isspace()
+static bool IsPySpace(QChar c)
+{
+    ushort u = c.unicode();
+    return ((u >= 0x09) && (u <= 0x0D)) || ((u >= 0x1C) && (u <= 0x20)) ||
+           (u == 0x85) || (u == 0xA0) || (u == 0x1680) || ((u >= 0x2000) && (u <= 0x200A)) ||
+           (u == 0x2028) || (u == 0x2029) || (u == 0x202F) || (u == 0x205F) || (u == 0x3000);
+}
+
+
+static QString PyStrip(const QString &s)
+{
+    int start = 0;
+    int end = s.length();
+    while ((start < end) && IsPySpace(s.at(start))) start++;
+    while ((end > start) && IsPySpace(s.at(end - 1))) end--;
+    return s.mid(start, end - start);
+}
+
+
+static QString RStrip(const QString &s, const QString &chars)
+{
+    int end = s.length();
+    while ((end > 0) && chars.contains(s.at(end - 1))) end--;
+    return s.left(end);
+}
+
+
+static bool IsHexDigit(QChar c)
+{
+    ushort u = c.unicode();
+    return ((u >= '0') && (u <= '9')) || ((u >= 'a') && (u <= 'f')) || ((u >= 'A') && (u <= 'F'));
+}
+
+
+// length of the entity &#\d+; or &#x[0-9a-fA-F]+; or &\w+; starting at pos, else 0
+static int EntityLength(const QString &s, int pos)
+{
+    int n = s.length();
+    int j = pos + 1;
+    char32_t cp;
+    if ((j < n) && (s.at(j) == '#')) {
+        int k = j + 1;
+        while (k < n) {
+            int len = CodePointAt(s, k, cp);
+            if (!QChar::isDigit(cp)) break;
+            k += len;
+        }
+        if ((k > j + 1) && (k < n) && (s.at(k) == ';')) return k + 1 - pos;
+        k = j + 1;
+        if ((k < n) && (s.at(k) == 'x')) {
+            k++;
+            int start = k;
+            while ((k < n) && IsHexDigit(s.at(k))) k++;
+            if ((k > start) && (k < n) && (s.at(k) == ';')) return k + 1 - pos;
+        }
+        return 0;
+    }
+    int k = j;
+    while (k < n) {
+        int len = CodePointAt(s, k, cp);
+        if (!IsWordChar(cp)) break;
+        k += len;
+    }
+    if ((k > j) && (k < n) && (s.at(k) == ';')) return k + 1 - pos;
+    return 0;
+}
+
+
+// sigil_bs4 BARE_AMPERSAND_OR_BRACKET substitution
+static QString EscapeBareAmpOrBracket(const QString &s)
+{
+    QString out;
+    out.reserve(s.length() + 16);
+    int n = s.length();
+    int i = 0;
+    while (i < n) {
+        QChar c = s.at(i);
+        if (c == '<') {
+            out.append("&lt;");
+        } else if (c == '>') {
+            out.append("&gt;");
+        } else if (c.unicode() == 0x00A0) {
+            out.append("&#160;");
+        } else if (c == '&') {
+            int len = EntityLength(s, i);
+            if (len > 0) {
+                out.append(s.mid(i, len));
+                i += len;
+                continue;
+            }
+            out.append("&amp;");
+        } else {
+            out.append(c);
+        }
+        i++;
+    }
+    return out;
+}
+
+
+// only &lt; &gt; and &amp; may survive in bs4 xml text
+static QString FixTextEntities(const QString &s)
+{
+    QString out;
+    out.reserve(s.length());
+    int n = s.length();
+    int i = 0;
+    while (i < n) {
+        if (s.at(i) == '&') {
+            int len = EntityLength(s, i);
+            if (len > 0) {
+                QString piece = s.mid(i, len);
+                if ((piece != "&lt;") && (piece != "&gt;") && (piece != "&amp;")) {
+                    piece = "&amp;" + piece.mid(1);
+                }
+                out.append(piece);
+                i += len;
+                continue;
+            }
+        }
+        out.append(s.at(i));
+        i++;
+    }
+    return out;
+}
+
+
+// see xmlencode() in opf_parser.py
+static QString XMLEncode(const QString &s)
+{
+    QString d(s);
+    d.replace("&quot;", "\"").replace("&gt;", ">").replace("&lt;", "<").replace("&amp;", "&");
+    d.replace("&", "&amp;").replace("<", "&lt;").replace(">", "&gt;").replace("\"", "&quot;");
+    return d;
+}
+
+
+static bool DecodeUTF8Bytes(QByteArray &bytes, QString &out)
+{
+    if (bytes.isEmpty()) return true;
+    QStringDecoder decoder(QStringDecoder::Utf8, QStringDecoder::Flag::Stateless);
+    QString decoded = decoder.decode(bytes);
+    bytes.clear();
+    if (decoder.hasError()) return false;
+    out.append(decoded);
+    return true;
+}
+
+
+// python's urllib.parse.unquote(), returns false where python would
+// have produced replacement characters for invalid utf-8
+static bool PyUnquote(const QString &s, QString &out)
+{
+    QByteArray bytes;
+    int n = s.length();
+    int i = 0;
+    while (i < n) {
+        QChar c = s.at(i);
+        if (c.unicode() >= 128) {
+            if (!DecodeUTF8Bytes(bytes, out)) return false;
+            out.append(c);
+            i++;
+            continue;
+        }
+        if ((c == '%') && (i + 2 < n) && IsHexDigit(s.at(i + 1)) && IsHexDigit(s.at(i + 2))) {
+            bytes.append(static_cast<char>(s.mid(i + 1, 2).toInt(nullptr, 16)));
+            i += 3;
+            continue;
+        }
+        bytes.append(static_cast<char>(c.unicode()));
+        i++;
+    }
+    return DecodeUTF8Bytes(bytes, out);
+}
+
+
+// see urlencodepart() in sigil_bs4
+static QString PyURLEncode(const QString &s)
+{
+    QString out;
+    int n = s.length();
+    int i = 0;
+    while (i < n) {
+        char32_t cp;
+        int len = CodePointAt(s, i, cp);
+        QString ch = s.mid(i, len);
+        if (Utility::NeedToPercentEncode(cp)) {
+            QByteArray b = ch.toUtf8();
+            for (int j = 0; j < b.size(); j++) {
+                out.append(QString("%%1").arg(static_cast<uchar>(b.at(j)), 2, 16, QChar('0')).toUpper());
+            }
+        } else {
+            out.append(ch);
+        }
+        i += len;
+    }
+    return out;
+}
+
+
+static bool IsASCII(QStringView s)
+{
+    for (QChar c : s) {
+        if (c.unicode() >= 128) return false;
+    }
+    return true;
+}
+
+
+NativeXMLProcessor::NativeXMLProcessor()
+    : m_Unhandled(false),
+      m_HaveLastTAttr(false),
+      m_NSRemap(false),
+      m_ItemCount(0),
+      m_HavePackage(false),
+      m_HaveMetadataAtts(false)
+{
+    QHash<QString, QString> xmlmap;
+    xmlmap[XML_NS] = "xml";
+    m_NSMaps << xmlmap;
+}
+
+
+bool NativeXMLProcessor::RepairXML(const QString &source, const QString &mtype, QString &result)
+{
+    QString data(source);
+    QRegularExpressionMatch mo = XML_HEADER.match(data);
+    if (mo.hasMatch()) {
+        data.remove(mo.capturedStart(), mo.capturedLength());
+    }
+    bool is_opf = (mtype == OPF_MTYPE);
+    NativeXMLProcessor processor;
+
+    // QXmlStreamReader is more forgiving than lxml in a few places,
+    // so treat those as not well-formed and let bs4 decide
+    QXmlStreamReader reader(data);
+    while (!reader.atEnd()) {
+        QXmlStreamReader::TokenType ttype = reader.readNext();
+        switch (ttype) {
+            case QXmlStreamReader::StartElement:
+                foreach(QXmlStreamNamespaceDeclaration decl, reader.namespaceDeclarations()) {
+                    if (decl.prefix().isEmpty() && decl.namespaceUri().isEmpty()) return false;
+                }
+                if (is_opf) {
+                    if (!IsASCII(reader.qualifiedName())) return false;
+                    foreach(QXmlStreamAttribute att, reader.attributes()) {
+                        if (!IsASCII(att.qualifiedName())) return false;
+                    }
+                    processor.StartElement(reader);
+                }
+                break;
+            case QXmlStreamReader::EndElement:
+                if (is_opf) processor.EndElement();
+                break;
+            case QXmlStreamReader::Characters:
+                if (reader.isCDATA()) {
+                    if (is_opf) return false;
+                } else {
+                    if (reader.text().contains(QLatin1String("]]>"))) return false;
+                    if (is_opf) processor.Characters(reader.text().toString());
+                }
+                break;
+            case QXmlStreamReader::Comment:
+                if (is_opf || reader.text().contains(QLatin1String("--")) ||
+                    reader.text().endsWith(QLatin1Char('-'))) return false;
+                break;
+            case QXmlStreamReader::DTD:
+            case QXmlStreamReader::ProcessingInstruction:
+                if (is_opf) return false;
+                break;
+            case QXmlStreamReader::EntityReference:
+            case QXmlStreamReader::Invalid:
+                return false;
+            default:
+                break;
+        }
+        if (processor.m_Unhandled) return false;
+    }
+    if (reader.hasError()) {
+        DBG qDebug() << "NativeXMLProcessor: not well-formed: " << reader.errorString();
+        return false;
+    }
+
+    // bs4 leaves well-formed xml other than the opf untouched
+    if (!is_opf) {
+        result = source;
+        return true;
+    }
+
+    if (!processor.m_HavePackage || !processor.m_HaveMetadataAtts) return false;
+    result = processor.RebuildOPF();
+    return true;
+}
+
+
+void NativeXMLProcessor::StartElement(QXmlStreamReader &reader)
+{
+    if (!m_OpenElements.isEmpty()) {
+        m_OpenElements.last().has_child = true;
+    }
+
+    // ordered prefix to uri map of the namespaces declared here, with
+    // sigil_bs4 standard prefixes forced onto the known namespaces
+    QList<std::pair<QString, QString> > nsmap;
+    foreach(QXmlStreamNamespaceDeclaration decl, reader.namespaceDeclarations()) {
+        QString uri = decl.namespaceUri().toString();
+        QString pfx;
+        if (!decl.prefix().isEmpty()) pfx = decl.prefix().toString();
+        QString newpfx = STD_PREFIXES.value(uri, pfx);
+        if ((newpfx == "opf") && pfx.isNull()) newpfx = QString();
+        bool found = false;
+        for (int i = 0; i < nsmap.size(); i++) {
+            if ((nsmap[i].first.isNull() == newpfx.isNull()) && (nsmap[i].first == newpfx)) {
+                nsmap[i].second = uri;
+                found = true;
+                break;
+            }
+        }
+        if (!found) nsmap << std::make_pair(newpfx, uri);
+    }
+
+    // an element without declarations pushes an empty map unless at the top level
+    bool pushed = false;
+    if (!nsmap.isEmpty() || (m_NSMaps.size() > 1)) {
+        QHash<QString, QString> inverted;
+        for (const auto &entry : nsmap) {
+            inverted[entry.second] = entry.first;
+        }
+        m_NSMaps << inverted;
+        pushed = true;
+    }
+
+    TagAtts atts;
+    foreach(QXmlStreamAttribute att, reader.attributes()) {
+        QString key = att.name().toString();
+        QString ns = att.namespaceUri().toString();
+        if (!ns.isEmpty()) {
+            for (int i = m_NSMaps.size() - 1; i >= 0; i--) {
+                if (m_NSMaps.at(i).contains(ns)) {
+                    QString apfx = m_NSMaps.at(i).value(ns);
+                    if (!apfx.isNull()) key = apfx + ":" + key;
+                    break;
+                }
+            }
+        }
+        atts.insert(key, att.value().toString());
+    }
+    for (const auto &entry : nsmap) {
+        atts.insert(entry.first.isNull() ? "xmlns" : "xmlns:" + entry.first, entry.second);
+    }
+
+    QString name = reader.name().toString();
+    QString ns = reader.namespaceUri().toString();
+    if (!ns.isEmpty()) {
+        QString tpfx;
+        bool have_unprefixed = false;
+        bool have_any = false;
+        foreach(const auto &inverted, m_NSMaps) {
+            if (inverted.contains(ns)) {
+                have_any = true;
+                QString p = inverted.value(ns);
+                if (p.isNull()) {
+                    have_unprefixed = true;
+                } else {
+                    tpfx = p;
+                }
+            }
+        }
+        if (have_any && !have_unprefixed) name = tpfx + ":" + name;
+    }
+
+    // attribute values as bs4 would serialize them
+    TagAtts raw;
+    foreach(const auto &pair, atts.pairs()) {
+        QString v = EscapeBareAmpOrBracket(pair.second);
+        v.replace("\"", "&quot;");
+        raw.insert(pair.first, v);
+    }
+
+    OpenElement elem;
+    elem.name = name;
+    elem.has_child = false;
+    elem.pushed_nsmap = pushed;
+    m_OpenElements << elem;
+    OPFBeginTag(name, raw);
+}
+
+
+void NativeXMLProcessor::EndElement()
+{
+    if (m_OpenElements.isEmpty()) {
+        m_Unhandled = true;
+        return;
+    }
+    OpenElement elem = m_OpenElements.takeLast();
+    if (elem.pushed_nsmap) m_NSMaps.removeLast();
+    if (elem.has_child) {
+        // bs4 would keep mixed markup that Opf_Parser can not represent
+        QString lname = elem.name.toLower();
+        if (lname.startsWith("opf:")) lname = lname.mid(4);
+        if (!OPF_PARENTS.contains(lname)) {
+            m_Unhandled = true;
+            return;
+        }
+    } else {
+        QString text = FixTextEntities(PyStrip(EscapeBareAmpOrBracket(elem.text)));
+        if (!text.isEmpty()) OPFContent(text);
+    }
+    OPFEndTag(elem.name);
+}
+
+
+void NativeXMLProcessor::Characters(const QString &text)
+{
+    if (!m_OpenElements.isEmpty()) {
+        m_OpenElements.last().text.append(text);
+    }
+}
+
+
+void NativeXMLProcessor::OPFBeginTag(const QString &name, const TagAtts &atts)
+{
+    QString tname = name.toLower();
+    TagAtts tattr;
+    foreach(const auto &pair, atts.pairs()) {
+        tattr.insert(RStrip(pair.first.toLower(), " \n\r\t"), pair.second);
+    }
+    if (tname.startsWith("opf:")) {
+        m_NSRemap = true;
+        tname = tname.mid(4);
+    }
+    m_TContent = QString();
+    m_Prefix << tname;
+    if (OPF_PARENTS.contains(tname)) {
+        OPFHandleTag(m_Prefix.join("."), tname, tattr);
+    } else {
+        m_LastTAttr = tattr;
+        m_HaveLastTAttr = true;
+    }
+}
+
+
+void NativeXMLProcessor::OPFEndTag(const QString &name)
+{
+    QString tname = name.toLower();
+    if (tname.startsWith("opf:")) {
+        m_NSRemap = true;
+        tname = tname.mid(4);
+    }
+    if (!m_Prefix.isEmpty()) m_Prefix.removeLast();
+    TagAtts tattr;
+    if (m_HaveLastTAttr) tattr = m_LastTAttr;
+    m_LastTAttr = TagAtts();
+    m_HaveLastTAttr = false;
+    if (!OPF_PARENTS.contains(tname)) {
+        OPFHandleTag(m_Prefix.join("."), tname, tattr);
+    }
+    m_TContent = QString();
+}
+
+
+void NativeXMLProcessor::OPFContent(const QString &content)
+{
+    m_TContent = RStrip(content, " \r\n");
+}
+
+
+void NativeXMLProcessor::OPFHandleTag(const QString &prefix, const QString &tname, TagAtts &tattr)
+{
+    if (tname == "package") {
+        m_Version = tattr.value("version", "2.0");
+        tattr.remove("version");
+        m_UniqueId = tattr.value("unique-identifier", "bookid");
+        tattr.remove("unique-identifier");
+        if (m_NSRemap && tattr.contains("xmlns:opf")) {
+            tattr.remove("xmlns:opf");
+            tattr.insert("xmlns", OPF_NS);
+        }
+        m_PackageAtts = tattr;
+        m_HavePackage = true;
+        return;
+    }
+    if (tname == "metadata") {
+        if (m_NSRemap && !tattr.contains("xmlns:opf")) {
+            tattr.insert("xmlns:opf", OPF_NS);
+        }
+        m_MetadataAtts = tattr;
+        m_HaveMetadataAtts = true;
+        return;
+    }
+    if ((tname == "meta") || (tname == "link") ||
+        (tname.startsWith("dc:") && prefix.contains("metadata"))) {
+        MetadataEntry entry;
+        entry.name = tname;
+        entry.content = m_TContent;
+        entry.atts = tattr;
+        m_Metadata << entry;
+        return;
+    }
+    if ((tname == "item") && prefix.contains("manifest")) {
+        QString nid = QString("xid%1").arg(m_ItemCount, 3, 10, QChar('0'));
+        m_ItemCount++;
+        ManifestEntry entry;
+        entry.id = tattr.value("id", nid);
+        tattr.remove("id");
+        QString href = tattr.value("href", "");
+        tattr.remove("href");
+        if (!href.contains(':')) {
+            QString unquoted;
+            if (!PyUnquote(href, unquoted)) {
+                m_Unhandled = true;
+                return;
+            }
+            href = PyURLEncode(unquoted);
+        }
+        entry.href = href;
+        entry.mtype = tattr.value("media-type", "");
+        tattr.remove("media-type");
+        entry.atts = tattr;
+        m_Manifest << entry;
+        return;
+    }
+    if (tname == "spine") {
+        m_SpineAtts = tattr;
+        return;
+    }
+    if ((tname == "itemref") && prefix.contains("spine")) {
+        SpineEntry entry;
+        entry.idref = tattr.value("idref", "");
+        tattr.remove("idref");
+        entry.atts = tattr;
+        m_Spine << entry;
+        return;
+    }
+    if ((tname == "reference") && prefix.contains("guide")) {
+        m_Guide << (QStringList() << tattr.value("type", "") << tattr.value("title", "")
+                                  << tattr.value("href", ""));
+        return;
+    }
+    if ((tname == "mediatype") && prefix.contains("bindings")) {
+        m_Bindings << (QStringList() << tattr.value("media-type", "") << tattr.value("handler", ""));
+        return;
+    }
+}
+
+
+// see rebuild_opfxml() in opf_parser.py
+QString NativeXMLProcessor::RebuildOPF()
+{
+    QStringList xml;
+    xml << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+    xml << "<package version=\"" + m_Version + "\" unique-identifier=\"" + m_UniqueId + "\"";
+    foreach(const auto &pair, m_PackageAtts.pairs()) {
+        xml << " " + pair.first + "=\"" + XMLEncode(pair.second) + "\"";
+    }
+    xml << ">\n";
+    xml << "  <metadata";
+    foreach(const auto &pair, m_MetadataAtts.pairs()) {
+        xml << " " + pair.first + "=\"" + XMLEncode(pair.second) + "\"";
+    }
+    xml << ">\n";
+    foreach(const MetadataEntry &entry, m_Metadata) {
+        xml << "    <" + entry.name;
+        foreach(const auto &pair, entry.atts.pairs()) {
+            xml << " " + pair.first + "=\"" + XMLEncode(pair.second) + "\"";
+        }
+        if (entry.content.isEmpty()) {
+            xml << "/>\n";
+        } else {
+            xml << ">" + XMLEncode(entry.content) + "</" + entry.name + ">\n";
+        }
+    }
+    xml << "  </metadata>\n";
+    xml << "  <manifest>\n";
+    foreach(const ManifestEntry &entry, m_Manifest) {
+        xml << "    <item id=\"" + entry.id + "\" href=\"" + entry.href + "\" media-type=\"" + entry.mtype + "\"";
+        foreach(const auto &pair, entry.atts.pairs()) {
+            xml << " " + pair.first + "=\"" + XMLEncode(pair.second) + "\"";
+        }
+        xml << "/>\n";
+    }
+    xml << "  </manifest>\n";
+    xml << "  <spine";
+    foreach(const auto &pair, m_SpineAtts.pairs()) {
+        xml << " " + pair.first + "=\"" + XMLEncode(pair.second) + "\"";
+    }
+    xml << ">\n";
+    foreach(const SpineEntry &entry, m_Spine) {
+        xml << "    <itemref idref=\"" + entry.idref + "\"";
+        foreach(const auto &pair, entry.atts.pairs()) {
+            xml << " " + pair.first + "=\"" + XMLEncode(pair.second) + "\"";
+        }
+        xml << "/>\n";
+    }
+    xml << "  </spine>\n";
+    if (!m_Guide.isEmpty()) {
+        xml << "  <guide>\n";
+        foreach(const QStringList &ref, m_Guide) {
+            xml << "    <reference type=\"" + ref.at(0) + "\" title=\"" + ref.at(1) + "\" href=\"" + ref.at(2) + "\"/>\n";
+        }
+        xml << "  </guide>\n";
+    }
+    if (!m_Bindings.isEmpty() && m_Version.startsWith("3")) {
+        xml << "  <bindings>\n";
+        foreach(const QStringList &binding, m_Bindings) {
+            xml << "  <mediaType media-type=\"" + binding.at(0) + "\" handler=\"" + binding.at(1) + "\"/>\n";
+        }
+        xml << "  </bindings>\n";
+    }
+    xml << "</package>\n";
+    return xml.join("");
+}
@@ -0,0 +1,127 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+#pragma once
+#ifndef NATIVEXMLPROCESSOR_H
+#define NATIVEXMLPROCESSOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+
+#include "Parsers/TagAtts.h"
+
+class QXmlStreamReader;
+
+// A native C++ counterpart to repairXML() in python3lib/xmlprocessor.py
+//
+// For well-formed xml it produces exactly what the BeautifulSoup4 path
+// (followed by Opf_Parser for the opf) would produce, without ever touching
+// the embedded python interpreter, so it may safely be used from any thread.
+//
+// Anything that needs real repair work, or that uses xml features whose bs4
+// round trip is not emulated here (comments, cdata, processing instructions,
+// doctypes in the opf, nested metadata markup, etc) is reported as
+// unhandled so that the caller can fall back to using bs4.
+
+class NativeXMLProcessor
+{
+public:
+
+    /**
+     * Repairs and prettyprints the xml natively if possible.
+     *
+     * @param source the xml text
+     * @param mtype the media-type of the xml
+     * @param result set to the processed xml when handled
+     * @return \c true if handled, \c false if the bs4 path must be used instead
+     */
+    static bool RepairXML(const QString &source, const QString &mtype, QString &result);
+
+private:
+
+    NativeXMLProcessor();
+
+    // emulation of the sigil_bs4 lxml tree builder
+    void StartElement(QXmlStreamReader &reader);
+    void EndElement();
+    void Characters(const QString &text);
+
+    // emulation of Opf_Parser as fed by the bs4 serialized opf
+    void OPFBeginTag(const QString &name, const TagAtts &atts);
+    void OPFEndTag(const QString &name);
+    void OPFContent(const QString &content);
+    void OPFHandleTag(const QString &prefix, const QString &tname, TagAtts &tattr);
+    QString RebuildOPF();
+
+    struct OpenElement {
+        QString name;
+        bool    has_child;
+        bool    pushed_nsmap;
+        QString text;
+    };
+
+    struct MetadataEntry {
+        QString name;
+        QString content;
+        TagAtts atts;
+    };
+
+    struct ManifestEntry {
+        QString id;
+        QString href;
+        QString mtype;
+        TagAtts atts;
+    };
+
+    struct SpineEntry {
+        QString idref;
+        TagAtts atts;
+    };
+
+    // inverted (uri to prefix) namespace maps, a null prefix means unprefixed
+    QList<QHash<QString, QString> > m_NSMaps;
+    QList<OpenElement> m_OpenElements;
+    bool m_Unhandled;
+
+    QString m_TContent;
+    TagAtts m_LastTAttr;
+    bool    m_HaveLastTAttr;
+    QStringList m_Prefix;
+    bool m_NSRemap;
+    int  m_ItemCount;
+
+    bool    m_HavePackage;
+    QString m_Version;
+    QString m_UniqueId;
+    TagAtts m_PackageAtts;
+    bool    m_HaveMetadataAtts;
+    TagAtts m_MetadataAtts;
+    TagAtts m_SpineAtts;
+    QList<MetadataEntry> m_Metadata;
+    QList<ManifestEntry> m_Manifest;
+    QList<SpineEntry>    m_Spine;
+    QList<QStringList>   m_Guide;
+    QList<QStringList>   m_Bindings;
+};
+
+#endif // NATIVEXMLPROCESSOR_H
@@ -202,6 +202,16 @@ bool CSelector::match(GumboNode* apNode)
     }
 }
 
+CSelector::TKeyType CSelector::rightmostKey(std::string& aValue, GumboTag& aTag)
+{
+    if (mOp == ETag)
+    {
+        aTag = mTag;
+        return ETagKey;
+    }
+    return ENoKey;
+}
+
 std::vector<GumboNode*> CSelector::filter(std::vector<GumboNode*> nodes)
 {
     std::vector<GumboNode*> ret;
@@ -353,6 +363,34 @@ bool CBinarySelector::match(GumboNode* apNode)
     return false;
 }
 
+CSelector::TKeyType CBinarySelector::rightmostKey(std::string& aValue, GumboTag& aTag)
+{
+    switch (mOp)
+    {
+        case EIntersection:
+        {
+            // both must match so use whichever key is the more selective
+            std::string value;
+            GumboTag tag = GumboTag(0);
+            TKeyType key1 = mpS1->rightmostKey(value, tag);
+            TKeyType key2 = mpS2->rightmostKey(aValue, aTag);
+            if (key1 > key2)
+            {
+                aValue = value;
+                aTag = tag;
+                return key1;
+            }
+            return key2;
+        }
+        case EChild:
+        case EDescendant:
+        case ESibling:
+            return mpS2->rightmostKey(aValue, aTag);
+        default:
+            return ENoKey;
+    }
+}
+
 CAttributeSelector::CAttributeSelector(TOperator aOp, std::string aKey, std::string aValue)
 {
     mKey = aKey;
@@ -431,6 +469,25 @@ bool CAttributeSelector::match(GumboNode* apNode)
     return false;
 }
 
+CSelector::TKeyType CAttributeSelector::rightmostKey(std::string& aValue, GumboTag& aTag)
+{
+    if (mValue.empty())
+    {
+        return ENoKey;
+    }
+    if (mOp == EEquals && mKey == "id")
+    {
+        aValue = mValue;
+        return EIdKey;
+    }
+    if (mOp == EIncludes && mKey == "class")
+    {
+        aValue = mValue;
+        return EClassKey;
+    }
+    return ENoKey;
+}
+
 CUnarySelector::CUnarySelector(TOperator aOp, CSelector* apS)
 {
     mpS = apS;
@@ -67,6 +67,18 @@ class CSelector: public CObject
         ELang,
     } TOperator;
 
+    typedef enum
+    {
+        // in order of increasing selectivity once past ENoKey
+        ENoKey,
+        //
+        ETagKey,
+        //
+        EClassKey,
+        //
+        EIdKey,
+    } TKeyType;
+
  public:
 
     CSelector(TOperator aOp = EDummy)
@@ -118,6 +130,11 @@ class CSelector: public CObject
 
     std::vector<GumboNode*> matchAll(GumboNode* apNode);
 
+    // the tag, class name (aValue), or id value (aValue) that every node
+    // this selector can match must have, or ENoKey if there is none
+    // used to bucket selectors when matching many of them in one walk
+    virtual TKeyType rightmostKey(std::string& aValue, GumboTag& aTag);
+
  private:
 
     void init()
@@ -221,6 +238,8 @@ class CBinarySelector: public CSelector
 
     virtual bool match(GumboNode* apNode);
 
+    virtual TKeyType rightmostKey(std::string& aValue, GumboTag& aTag);
+
  private:
 
     CSelector* mpS1;
@@ -264,6 +283,8 @@ class CAttributeSelector: public CSelector
 
     virtual bool match(GumboNode* apNode);
 
+    virtual TKeyType rightmostKey(std::string& aValue, GumboTag& aTag);
+
  private:
 
      std::string mKey;
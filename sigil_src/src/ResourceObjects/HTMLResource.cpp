@@ -27,6 +27,7 @@
 // #include <QDebug>
 
 #include "BookManipulation/CleanSource.h"
+#include "BookManipulation/HTMLIndex.h"
 #include "BookManipulation/XhtmlDoc.h"
 #include "Misc/Utility.h"
 #include "Parsers/GumboInterface.h"
@@ -53,7 +54,10 @@ HTMLResource::HTMLResource(const QString &mainfolder, const QString &fullfilepat
     XMLResource(mainfolder, fullfilepath, parent),
     m_Keeper(Keeper),
     m_LinkedBookPaths(QStringList()),
-    m_TOCCache("")
+    m_TOCCache(""),
+    m_HTMLIndexRevision(-1),
+    m_WellFormed(false),
+    m_WellFormedRevision(-1)
 {
 }
 
@@ -110,7 +114,7 @@ void HTMLResource::SaveToDisk(bool book_wide_save)
 
 QStringList HTMLResource::GetLinkedStylesheets()
 {
-    QStringList hreflist = XhtmlDoc::GetLinkedStylesheets(GetText());
+    QStringList hreflist = GetHTMLIndex()->LinkedStylesheets();
     QString startdir = GetFolder();
     QStringList stylesheet_bookpaths;
     foreach(QString ahref, hreflist) {
@@ -157,6 +161,34 @@ QStringList HTMLResource::GetManifestProperties() const
 }
 
 
+QSharedPointer<const HTMLIndex> HTMLResource::GetHTMLIndex() const
+{
+    QMutexLocker locker(&m_HTMLIndexMutex);
+    // read the revision before the text so that a concurrent change
+    // can only ever cause an extra rebuild, never a stale index
+    int revision = GetTextRevision();
+    if (m_HTMLIndex.isNull() || (m_HTMLIndexRevision != revision)) {
+        m_HTMLIndex = QSharedPointer<const HTMLIndex>(new HTMLIndex(GetText()));
+        m_HTMLIndexRevision = revision;
+    }
+    return m_HTMLIndex;
+}
+
+
+bool HTMLResource::IsWellFormed(const QString &version) const
+{
+    QMutexLocker locker(&m_WellFormedMutex);
+    // as for the index, read the revision before the text
+    int revision = GetTextRevision();
+    if ((m_WellFormedRevision != revision) || (m_WellFormedVersion != version)) {
+        m_WellFormed = XhtmlDoc::IsDataWellFormed(GetText(), version);
+        m_WellFormedRevision = revision;
+        m_WellFormedVersion = version;
+    }
+    return m_WellFormed;
+}
+
+
 QStringList HTMLResource::SplitOnSGFSectionMarkers()
 {
     QStringList sections = XhtmlDoc::GetSGFSectionSplits(GetText());
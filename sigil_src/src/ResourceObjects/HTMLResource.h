@@ -25,12 +25,15 @@
 #define HTMLRESOURCE_H
 
 #include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
 
 #include "Parsers/CSSInfo.h"
 #include "ResourceObjects/XMLResource.h"
 
 class QString;
 class FolderKeeper;
+class HTMLIndex;
 
 /**
  * Represents an HTML file of the book.
@@ -99,6 +102,23 @@ public:
 
     QStringList GetManifestProperties() const;
 
+    /**
+     * Returns the ids, links, classes and media references of this file.
+     * The index is built on first use and then reused until the text changes.
+     *
+     * @return The index for the current text.
+     */
+    QSharedPointer<const HTMLIndex> GetHTMLIndex() const;
+
+    /**
+     * Returns whether the text is well formed, exactly as
+     * XhtmlDoc::IsDataWellFormed reports it for the given epub version.
+     * The verdict is reused until the text changes.
+     *
+     * @return \c true if the current text is well formed.
+     */
+    bool IsWellFormed(const QString &version = "2.0") const;
+
     bool DeleteCSStyles(QList<CSSInfo::CSSSelector *> css_selectors);
 
     QString GetLanguageAttribute();
@@ -127,6 +147,15 @@ private:
     QStringList m_LinkedBookPaths;
 
     QString m_TOCCache;
+
+    mutable QSharedPointer<const HTMLIndex> m_HTMLIndex;
+    mutable int m_HTMLIndexRevision;
+    mutable QMutex m_HTMLIndexMutex;
+
+    mutable bool m_WellFormed;
+    mutable int m_WellFormedRevision;
+    mutable QString m_WellFormedVersion;
+    mutable QMutex m_WellFormedMutex;
 };
 
 #endif // HTMLRESOURCE_H
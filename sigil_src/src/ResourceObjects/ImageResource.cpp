@@ -20,7 +20,7 @@
 **
 *************************************************************************/
 
-#include <QImage>
+#include "Misc/ImageInfoCache.h"
 #include "Misc/Utility.h"
 #include "ResourceObjects/ImageResource.h"
 
@@ -46,15 +46,15 @@ bool ImageResource::LoadFromDisk()
 QString ImageResource::GetDescription() const
 {
     const QString path = GetFullPath();
-    const QImage img(path);
-    QString colors_shades = img.isGrayscale() ? tr("shades") : tr("colors");
-    QString grayscale_color = img.isGrayscale() ? tr("Grayscale") : tr("Color");
+    const ImageInfoCache::ImageInfo img = ImageInfoCache::instance()->Info(path);
+    QString colors_shades = img.grayscale ? tr("shades") : tr("colors");
+    QString grayscale_color = img.grayscale ? tr("Grayscale") : tr("Color");
     QString colorsInfo = "";
-    if (img.depth() == 32) {
-        colorsInfo = QString(" %1bpp").arg(img.bitPlaneCount());
-    } else if (img.depth() > 0) {
-        colorsInfo = QString(" %1bpp (%2 %3)").arg(img.bitPlaneCount()).arg(img.colorCount()).arg(colors_shades);
+    if (img.depth == 32) {
+        colorsInfo = QString(" %1bpp").arg(img.bitPlaneCount);
+    } else if (img.depth > 0) {
+        colorsInfo = QString(" %1bpp (%2 %3)").arg(img.bitPlaneCount).arg(img.colorCount).arg(colors_shades);
     }
-    QString description = QString("(%1px ✕ %2px) %3%4").arg(img.width()).arg(img.height()).arg(grayscale_color).arg(colorsInfo);
+    QString description = QString("(%1px ✕ %2px) %3%4").arg(img.width).arg(img.height).arg(grayscale_color).arg(colorsInfo);
     return description;
 }
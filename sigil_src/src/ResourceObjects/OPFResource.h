@@ -26,6 +26,7 @@
 #define OPFRESOURCE_H
 
 #include <memory>
+#include <QMutex>
 #include <QStringList>
 #include <QHash>
 #include <QString>
@@ -198,6 +199,12 @@ public slots:
 
 private:
 
+    /**
+     * Returns the parsed OPF model for the current text.
+     * The model is cached and only rebuilt when the text changes.
+     */
+    OPFParser GetParsedOPF() const;
+
     /**
      * Determines if a cover image exists.
      *
@@ -286,6 +293,14 @@ private:
 
     HTMLResource * m_NavResource;
     bool m_WarnedAboutVersion;
+
+    /**
+     * The cached parsed OPF model, valid only while
+     * m_ParsedOPFRevision matches GetTextRevision().
+     */
+    mutable OPFParser m_ParsedOPF;
+    mutable int m_ParsedOPFRevision;
+    mutable QMutex m_ParsedOPFMutex;
 };
 
 #endif // OPFRESOURCE_H
@@ -32,6 +32,9 @@
 
 const int WAIT_FOR_WRITE_DELAY = 100;
 
+// the coarsest file modification time resolution in use (FAT)
+const qint64 MODIFIED_TIME_TICK = 2000;
+
 Resource::Resource(const QString &mainfolder, const QString &fullfilepath, QObject *parent)
     :
     QObject(parent),
@@ -274,6 +277,39 @@ void Resource::SaveToDisk(bool book_wide_save)
     }
 }
 
+void Resource::SetWrittenCRC32(const QString &crc32)
+{
+    QFileInfo fileinfo(m_FullFilePath);
+    const QDateTime lastModifiedDate = fileinfo.lastModified();
+    m_WrittenCRC32 = crc32;
+    m_WrittenModified = lastModifiedDate.isValid() ? lastModifiedDate.toMSecsSinceEpoch() : 0;
+    m_WrittenSize = fileinfo.size();
+    m_WrittenStamped = QDateTime::currentMSecsSinceEpoch();
+}
+
+QString Resource::GetWrittenCRC32() const
+{
+    if (m_WrittenCRC32.isEmpty()) {
+        return QString();
+    }
+
+    QFileInfo fileinfo(m_FullFilePath);
+    const QDateTime lastModifiedDate = fileinfo.lastModified();
+    qint64 modified = lastModifiedDate.isValid() ? lastModifiedDate.toMSecsSinceEpoch() : 0;
+
+    if ((modified != m_WrittenModified) || (fileinfo.size() != m_WrittenSize)) {
+        return QString();
+    }
+    return m_WrittenCRC32;
+}
+
+bool Resource::WrittenCRC32MayBeStale() const
+{
+    // a rewrite within the same tick as the one the checksum was
+    // recorded in would leave the modification time unchanged
+    return m_WrittenModified + MODIFIED_TIME_TICK >= m_WrittenStamped;
+}
+
 void Resource::FileChangedOnDisk()
 {
     QFileInfo latestFileInfo(m_FullFilePath);
@@ -173,6 +173,25 @@ public:
     void SetSavedSize(const size_t info) { m_SavedSize = info; }
     size_t GetSavedSize() { return m_SavedSize; }
 
+    /**
+     * Records the crc32 checksum of the resource's file as it is on
+     * disk right now (along with its size and modification time).
+     */
+    void SetWrittenCRC32(const QString& crc32);
+
+    /**
+     * Returns the crc32 checksum recorded for the resource's file,
+     * or an empty string if the file has changed on disk since.
+     */
+    QString GetWrittenCRC32() const;
+
+    /**
+     * Returns true if the file was modified so shortly before its
+     * checksum was recorded that a later rewrite of the same size
+     * could have gone unnoticed.
+     */
+    bool WrittenCRC32MayBeStale() const;
+
 
     /**
      * Returns a reference to the resource's ReadWriteLock.
@@ -354,6 +373,19 @@ private:
 
     size_t m_SavedSize = 0;
 
+    /**
+     * The crc32 of the resource's file when last checksummed,
+     * that file's modification time and size at that point
+     * and when that was.
+     */
+    QString m_WrittenCRC32;
+
+    qint64 m_WrittenModified = 0;
+
+    qint64 m_WrittenSize = 0;
+
+    qint64 m_WrittenStamped = 0;
+
     /**
      * The ReadWriteLock guarding access to the resource's data.
      */
@@ -35,11 +35,12 @@ TextResource::TextResource(const QString &mainfolder, const QString &fullfilepat
     :
     Resource(mainfolder, fullfilepath, parent),
     m_CacheInUse(false),
-    m_TextDocument(new TextDocument(this)),
-    m_IsLoaded(false)
+    m_TextDocument(NULL),
+    m_IsLoaded(false),
+    m_TextRevision(0),
+    m_SnapshotRevision(0),
+    m_SettingText(false)
 {
-    m_TextDocument->setDocumentLayout(new QPlainTextDocumentLayout(m_TextDocument));
-    connect(m_TextDocument, SIGNAL(contentsChanged()), this, SIGNAL(Modified()));
 }
 
 
@@ -51,7 +52,19 @@ QString TextResource::GetText() const
         return m_Cache;
     }
 
-    return m_TextDocument->toText();
+    // Without a text document the snapshot is the text itself
+    int revision = m_TextRevision.loadAcquire();
+    if (m_TextDocument && (m_SnapshotRevision != revision)) {
+        m_Snapshot = m_TextDocument->toText();
+        m_SnapshotRevision = revision;
+    }
+    return m_Snapshot;
+}
+
+
+int TextResource::GetTextRevision() const
+{
+    return m_TextRevision.loadAcquire();
 }
 
 
@@ -67,24 +80,57 @@ void TextResource::SetText(const QString &text)
     //   So we cache the text update into m_Cache and update the QTextDocument
     // when we return to the GUI thread. The single-shot timer makes sure
     // of that.
+    //   Until a view needs it there is no QTextDocument at all though,
+    // and the text is simply stored as is from whatever thread.
     if (QThread::currentThread() == QApplication::instance()->thread()) {
-        SetTextInternal(text);
-    } else {
+        if (m_TextDocument) {
+            SetTextInternal(text);
+            m_TextRevision.fetchAndAddOrdered(1);
+            return;
+        }
+    }
+
+    {
         QMutexLocker locker(&m_CacheAccessMutex);
-        m_Cache = text;
+        m_TextRevision.fetchAndAddOrdered(1);
+
+        if (m_TextDocument) {
+            m_Cache = text;
 
-        // We want to make sure we schedule only one delayed update
-        if (!m_CacheInUse) {
-            m_CacheInUse = true;
-            QTimer::singleShot(0, this, SLOT(DelayedUpdateToTextDocument()));
+            // We want to make sure we schedule only one delayed update
+            if (!m_CacheInUse) {
+                m_CacheInUse = true;
+                QTimer::singleShot(0, this, SLOT(DelayedUpdateToTextDocument()));
+            }
+            return;
         }
+
+        SetPlainTextInternal(text);
     }
+
+    emit Modified();
 }
 
 
-TextDocument& TextResource::GetTextDocumentForWriting()
+TextDocument& TextResource::GetTextDocumentForWriting(QObject *view)
 {
-    Q_ASSERT(m_TextDocument);
+    if (!m_TextDocument) {
+        TextDocument *document = new TextDocument(this);
+        document->setDocumentLayout(new QPlainTextDocumentLayout(document));
+        QMutexLocker locker(&m_CacheAccessMutex);
+        document->setPlainText(m_CacheInUse ? m_Cache : m_Snapshot);
+        document->setModified(false);
+        m_CacheInUse = false;
+        m_TextDocument = document;
+        connect(m_TextDocument, SIGNAL(contentsChanged()), this, SLOT(TextDocumentChanged()));
+        connect(m_TextDocument, SIGNAL(contentsChanged()), this, SIGNAL(Modified()));
+    }
+
+    if (view && !m_Views.contains(view)) {
+        m_Views.insert(view);
+        connect(view, SIGNAL(destroyed(QObject *)), this, SLOT(ViewDestroyed(QObject *)));
+    }
+
     return *m_TextDocument;
 }
 
@@ -105,10 +151,12 @@ void TextResource::SaveToDisk(bool book_wide_save)
 
         // But we always want to save the most up to date version
 
+        // Keep the checksum of what was written so that
+        // epub export does not need to read it back again
         if (m_CacheInUse) {
-            Utility::WriteUnicodeTextFile(m_Cache, GetFullPath());
+            SetWrittenCRC32(Utility::WriteUnicodeTextFile(m_Cache, GetFullPath()));
         } else {
-            Utility::WriteUnicodeTextFile(GetText(), GetFullPath());
+            SetWrittenCRC32(Utility::WriteUnicodeTextFile(GetText(), GetFullPath()));
         }
     }
 
@@ -116,7 +164,9 @@ void TextResource::SaveToDisk(bool book_wide_save)
         emit ResourceUpdatedOnDisk();
     }
 
-    m_TextDocument->setModified(false);
+    if (m_TextDocument) {
+        m_TextDocument->setModified(false);
+    }
     Resource::SaveToDisk(book_wide_save);
 }
 
@@ -144,9 +194,13 @@ void TextResource::InitialLoad()
       * it had been opened in a tab first.
       */
     QWriteLocker locker(&GetLock());
-    Q_ASSERT(m_TextDocument);
+    bool is_empty = false;
+    {
+        QMutexLocker cache_locker(&m_CacheAccessMutex);
+        is_empty = m_TextDocument ? m_TextDocument->isEmpty() : m_Snapshot.isEmpty();
+    }
 
-    if (m_TextDocument->isEmpty() && QFile::exists(GetFullPath())) {
+    if (is_empty && QFile::exists(GetFullPath())) {
         SetText(Utility::ReadUnicodeTextFile(GetFullPath()));
     }
 }
@@ -161,15 +215,25 @@ bool TextResource::LoadFromDisk()
 {
     try {
         const QString &text = Utility::ReadUnicodeTextFile(GetFullPath());
-        QMutexLocker locker(&m_CacheAccessMutex);
-        m_Cache = text;
-
-        // We want to make sure we schedule only one delayed update
-        if (!m_CacheInUse) {
-            m_CacheInUse = true;
-            QTimer::singleShot(0, this, SLOT(DelayedUpdateToTextDocument()));
+        {
+            QMutexLocker locker(&m_CacheAccessMutex);
+            m_TextRevision.fetchAndAddOrdered(1);
+
+            if (m_TextDocument) {
+                m_Cache = text;
+
+                // We want to make sure we schedule only one delayed update
+                if (!m_CacheInUse) {
+                    m_CacheInUse = true;
+                    QTimer::singleShot(0, this, SLOT(DelayedUpdateToTextDocument()));
+                }
+                return true;
+            }
+
+            SetPlainTextInternal(text);
         }
 
+        emit Modified();
         return true;
     } catch (CannotOpenFile&) {
         // ?
@@ -183,7 +247,7 @@ void TextResource::DelayedUpdateToTextDocument()
 {
     QMutexLocker locker(&m_CacheAccessMutex);
 
-    if (!m_CacheInUse) {
+    if (!m_CacheInUse || !m_TextDocument) {
         return;
     }
 
@@ -191,9 +255,44 @@ void TextResource::DelayedUpdateToTextDocument()
 }
 
 
+void TextResource::ViewDestroyed(QObject *view)
+{
+    m_Views.remove(view);
+
+    if (!m_Views.isEmpty() || !m_TextDocument) {
+        return;
+    }
+
+    // The last view is gone so keep just the text again
+    QMutexLocker locker(&m_CacheAccessMutex);
+    if (m_CacheInUse) {
+        m_Snapshot = NormalizeText(m_Cache);
+    } else {
+        m_Snapshot = m_TextDocument->toText();
+    }
+    m_SnapshotRevision = m_TextRevision.loadAcquire();
+    m_CacheInUse = false;
+
+    // The view's own parts may still be tearing down around the document
+    m_TextDocument->disconnect(this);
+    m_TextDocument->deleteLater();
+    m_TextDocument = NULL;
+}
+
+
+void TextResource::TextDocumentChanged()
+{
+    if (!m_SettingText) {
+        m_TextRevision.fetchAndAddOrdered(1);
+    }
+}
+
+
 void TextResource::SetTextInternal(const QString &text)
 {
+    m_SettingText = true;
     m_TextDocument->setPlainText(text);
+    m_SettingText = false;
     m_TextDocument->setModified(false);
     // Our resource has now been loaded with some text
     m_IsLoaded = true;
@@ -202,6 +301,54 @@ void TextResource::SetTextInternal(const QString &text)
     // m_Cache = "";
 }
 
+void TextResource::SetPlainTextInternal(const QString &text)
+{
+    m_Snapshot = NormalizeText(text);
+    m_SnapshotRevision = m_TextRevision.loadAcquire();
+    // Our resource has now been loaded with some text
+    m_IsLoaded = true;
+    m_CacheInUse = false;
+}
+
+
+// The text exactly as a QTextDocument would give it back after
+// setPlainText(), so it does not matter whether one is in use:
+// every line break (\r\n, \r or a unicode separator) becomes \n
+QString TextResource::NormalizeText(const QString &text)
+{
+    auto is_break = [](char16_t c) {
+        return (c == u'\r') || (c == 0xfdd0) || (c == 0xfdd1) || // QTextBeginningOfFrame, QTextEndOfFrame
+               (c == QChar::ParagraphSeparator) || (c == QChar::LineSeparator);
+    };
+
+    // most text has nothing to change so leave it shared
+    const QChar *begin = text.constData();
+    const QChar *end = begin + text.size();
+    const QChar *p = begin;
+    while ((p != end) && !is_break(p->unicode())) {
+        ++p;
+    }
+    if (p == end) {
+        return text;
+    }
+
+    QString txt;
+    txt.reserve(text.size());
+    txt.append(begin, p - begin);
+    for (; p != end; ++p) {
+        char16_t c = p->unicode();
+        if (is_break(c)) {
+            if ((c == u'\r') && (p + 1 != end) && (p[1] == u'\n')) {
+                ++p;
+            }
+            txt.append(QLatin1Char('\n'));
+        } else {
+            txt.append(*p);
+        }
+    }
+    return txt;
+}
+
 bool TextResource::IsLoaded()
 {
     return m_IsLoaded;
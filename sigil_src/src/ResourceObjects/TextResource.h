@@ -24,7 +24,9 @@
 #ifndef TEXTRESOURCE_H
 #define TEXTRESOURCE_H
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QMutex>
+#include <QtCore/QSet>
 #include "Widgets/TextDocument.h"
 #include "ResourceObjects/Resource.h"
 
@@ -57,6 +59,16 @@ public:
      */
     virtual QString GetText() const;
 
+    /**
+     * Returns the revision of the resource text. It changes every time
+     * the text does, so callers can cache data derived from GetText()
+     * against it. Read the revision before the text, so that a concurrent
+     * change can only make such a cache look stale, never look current.
+     *
+     * @return The text revision.
+     */
+    int GetTextRevision() const;
+
     /**
      * Sets the text of the resource, replacing the stored content.
      */
@@ -64,13 +76,18 @@ public:
 
     /**
      * Returns a reference to the QTextDocument that can be read and written to
-     * in consumers. If you need just read access, use GetTextDocumentForReading().
+     * in consumers. If you need just read access, use GetText().
+     *
+     * The document is only built when first asked for (the text is kept
+     * as a plain string until then) and is dropped again once every view
+     * it was handed to has been destroyed. Must be called from the GUI thread.
      *
      * @warning Make sure to get a write lock externally before calling this function!
      *
+     * @param view The view (code view) that will show the document.
      * @return A reference to the QTextDocument cache.
      */
-    TextDocument &GetTextDocumentForWriting();
+    TextDocument &GetTextDocumentForWriting(QObject *view);
 
     // inherited
     void SaveToDisk(bool book_wide_save = false);
@@ -98,6 +115,17 @@ private slots:
      */
     void DelayedUpdateToTextDocument();
 
+    /**
+     * Bumps the text revision for edits made directly
+     * to m_TextDocument (in a Code View tab, undo, etc).
+     */
+    void TextDocumentChanged();
+
+    /**
+     * Drops m_TextDocument once the last view using it is gone.
+     */
+    void ViewDestroyed(QObject *view);
+
 private:
 
     /**
@@ -107,6 +135,16 @@ private:
      */
     void SetTextInternal(const QString &text);
 
+    /**
+     * Sets the text while there is no m_TextDocument.
+     * The caller must hold m_CacheAccessMutex.
+     *
+     * @param text The text to set.
+     */
+    void SetPlainTextInternal(const QString &text);
+
+    static QString NormalizeText(const QString &text);
+
 
     ///////////////////////////////
     // PRIVATE MEMBER VARIABLES
@@ -128,11 +166,37 @@ private:
     mutable QMutex m_CacheAccessMutex;
 
     /**
-     * The syntax colored cache of the TextResource text content.
+     * The syntax colored cache of the TextResource text content,
+     * only present while a view is using it.
      */
     TextDocument *m_TextDocument;
 
+    /**
+     * The views m_TextDocument has been handed to.
+     */
+    QSet<QObject *> m_Views;
+
     bool m_IsLoaded;
+
+    /**
+     * Bumped every time the text changes.
+     */
+    QAtomicInt m_TextRevision;
+
+    /**
+     * The text of m_TextDocument as of m_SnapshotRevision, so that
+     * it is only rebuilt from the document blocks once per revision.
+     * Without m_TextDocument it is the text itself.
+     * Guarded by m_CacheAccessMutex.
+     */
+    mutable QString m_Snapshot;
+    mutable int m_SnapshotRevision;
+
+    /**
+     * If \c true, SetTextInternal() is loading text whose
+     * revision has already been counted.
+     */
+    bool m_SettingText;
 };
 
 #endif // TEXTRESOURCE_H
@@ -374,6 +374,7 @@ class Options(ctypes.Structure):
         ('stop_on_first_error', ctypes.c_bool),
         ('max_tree_depth', ctypes.c_uint),
         ('max_errors', ctypes.c_int),
+        ('use_arena', ctypes.c_bool),
         ]
 
 
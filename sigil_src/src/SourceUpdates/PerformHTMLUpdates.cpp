@@ -45,15 +45,15 @@ PerformHTMLUpdates::PerformHTMLUpdates(const QString &source,
 QString PerformHTMLUpdates::operator()()
 {
     QString newsource = CleanSource::PreprocessSpecialCases(m_source);
-    { 
+    if (m_CSSUpdates.isEmpty()) {
         GumboInterface gi = GumboInterface(newsource, m_version, m_HTMLUpdates);
         gi.parse();
         newsource = gi.perform_source_updates(m_CurrentPath, m_newbookpath);
-    }
-    if (!m_CSSUpdates.isEmpty()) {
-        GumboInterface gi = GumboInterface(newsource, m_version, m_CSSUpdates);
+    } else {
+        // attribute links and style urls are both updated in one parse and serialization
+        GumboInterface gi = GumboInterface(newsource, m_version, m_HTMLUpdates, m_CSSUpdates);
         gi.parse();
-        newsource = gi.perform_style_updates(m_CurrentPath, m_newbookpath);
+        newsource = gi.perform_source_and_style_updates(m_CurrentPath, m_newbookpath);
     }
     return CleanSource::CharToEntity(newsource, m_version);
 }
@@ -135,7 +135,7 @@ void FlowTab::CreateCodeViewIfRequired(bool is_delayed_load)
         // CodeView (if already loaded) will be directly hooked into the TextResource and
         // will not need reloading. However if the tab was not in Code View at tab opening
         // then we must populate it now.
-        m_wCodeView->CustomSetDocument(m_HTMLResource->GetTextDocumentForWriting());
+        m_wCodeView->CustomSetDocument(m_HTMLResource->GetTextDocumentForWriting(m_wCodeView));
         // Zoom assignment only works after the document has been loaded
         m_wCodeView->Zoom();
     }
@@ -146,7 +146,7 @@ void FlowTab::CreateCodeViewIfRequired(bool is_delayed_load)
 void FlowTab::DelayedInitialization()
 {
     if (m_wCodeView) {
-        m_wCodeView->CustomSetDocument(m_HTMLResource->GetTextDocumentForWriting());
+        m_wCodeView->CustomSetDocument(m_HTMLResource->GetTextDocumentForWriting(m_wCodeView));
         // Zoom factor for CodeView can only be set when document has been loaded.
         m_wCodeView->Zoom();
     }
@@ -231,7 +231,9 @@ void FlowTab::SaveTabContent()
 {
     // In CV, the connection between QPlainTextEdit and the underlying QTextDocument
     //        means the resource already is "saved". We just need to reset modified state.
-    m_HTMLResource->GetTextDocumentForWriting().setModified(false);
+    if (m_wCodeView) {
+        m_wCodeView->document()->setModified(false);
+    }
 }
 
 void FlowTab::ResourceModified()
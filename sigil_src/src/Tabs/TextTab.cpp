@@ -280,7 +280,7 @@ void TextTab::EmitUpdateCursorPosition()
 
 void TextTab::DelayedInitialization()
 {
-    m_wCodeView->CustomSetDocument(m_TextResource->GetTextDocumentForWriting());
+    m_wCodeView->CustomSetDocument(m_TextResource->GetTextDocumentForWriting(m_wCodeView));
     m_wCodeView->Zoom();
     if (m_PositionToScrollTo >= 0) {
         m_wCodeView->ScrollToPosition(m_PositionToScrollTo);
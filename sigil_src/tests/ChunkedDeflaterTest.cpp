@@ -0,0 +1,202 @@
+/************************************************************************
+**
+**  Copyright (C) 2026 Kevin B. Hendricks, Stratford Ontario Canada
+**
+**  This file is part of Sigil.
+**
+**  Sigil is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  Sigil is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with Sigil.  If not, see <http://www.gnu.org/licenses/>.
+**
+*************************************************************************/
+
+
+// Saves files below, at and above the chunk size (and enough of them to
+// need more than one window of chunks) with ChunkedDeflater, then reads the
+// archive back with minizip, which checks each entry against its crc.
+// Usage: chunkeddeflater_test [archive path to keep for further checks]
+
+#include <stdio.h>
+#include <string.h>
+
+#include <zlib.h>
+#include <zip.h>
+#include <unzip.h>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThreadPool>
+
+#include "Exporters/ChunkedDeflater.h"
+
+static const qint64 CHUNK = ChunkedDeflater::CHUNK_SIZE;
+
+
+// Text that repeats across the chunk boundaries (so the primed dictionary
+// matters) with runs of noise that do not compress at all
+static QByteArray TestData(qint64 size, unsigned int seed)
+{
+    static const char text[] = "<p class=\"indent\">It was a dark and stormy night; the rain fell in torrents.</p>\n";
+    QByteArray data;
+    data.reserve(size);
+    while (data.size() < size) {
+        seed = seed * 1103515245 + 12345;
+        if ((seed >> 16) % 4 == 0) {
+            for (int i = 0; (i < 512) && (data.size() < size); i++) {
+                seed = seed * 1103515245 + 12345;
+                data.append((char) (seed >> 16));
+            }
+        } else {
+            data.append(text, qMin((qint64) sizeof(text) - 1, size - data.size()));
+        }
+    }
+    return data;
+}
+
+
+static bool WriteArchive(const QString &zippath, const QString &folder, const QStringList &names)
+{
+    zipFile zfile = zipOpen64(QDir::toNativeSeparators(zippath).toUtf8().constData(), APPEND_STATUS_CREATE);
+    if (zfile == NULL) {
+        fprintf(stderr, "cannot create %s\n", qPrintable(zippath));
+        return false;
+    }
+
+    ChunkedDeflater deflater;
+    QList<int> files;
+    foreach(QString name, names) {
+        files.append(deflater.AddFile(folder + "/" + name, QFile(folder + "/" + name).size()));
+    }
+
+    zip_fileinfo fileInfo;
+    memset(&fileInfo, 0, sizeof(fileInfo));
+    bool ok = true;
+    for (int i = 0; ok && (i < names.count()); i++) {
+        qint64 size = QFile(folder + "/" + names.at(i)).size();
+        uLong crc = 0;
+        ok = (zipOpenNewFileInZip4_64(zfile, names.at(i).toUtf8().constData(), &fileInfo, NULL, 0, NULL, 0, NULL,
+                                      Z_DEFLATED, ChunkedDeflater::LEVEL, 1, 15, 8, Z_DEFAULT_STRATEGY,
+                                      NULL, 0, 0x0b00, 1<<11, 0) == ZIP_OK) &&
+             (deflater.WriteFile(zfile, files.at(i), crc) == ChunkedDeflater::Written) &&
+             (zipCloseFileInZipRaw64(zfile, size, crc) == ZIP_OK);
+        if (!ok) {
+            fprintf(stderr, "cannot store %s\n", qPrintable(names.at(i)));
+        }
+    }
+    return (zipClose(zfile, NULL) == ZIP_OK) && ok;
+}
+
+
+static bool CheckArchive(const QString &zippath, const QString &folder, const QStringList &names)
+{
+    unzFile zfile = unzOpen64(QDir::toNativeSeparators(zippath).toUtf8().constData());
+    if (zfile == NULL) {
+        fprintf(stderr, "cannot open %s\n", qPrintable(zippath));
+        return false;
+    }
+
+    bool ok = true;
+    foreach(QString name, names) {
+        QFile file(folder + "/" + name);
+        file.open(QIODevice::ReadOnly);
+        QByteArray expected = file.readAll();
+        file.close();
+
+        unz_file_info64 file_info;
+        QByteArray found;
+        char buff[8192];
+        int read = 0;
+        if ((unzLocateFile(zfile, name.toUtf8().constData(), 1) != UNZ_OK) ||
+            (unzGetCurrentFileInfo64(zfile, &file_info, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK) ||
+            (unzOpenCurrentFile(zfile) != UNZ_OK)) {
+            fprintf(stderr, "%s: missing\n", qPrintable(name));
+            ok = false;
+            continue;
+        }
+        while ((read = unzReadCurrentFile(zfile, buff, sizeof(buff))) > 0) {
+            found.append(buff, read);
+        }
+        // closing a fully read entry is where minizip checks its crc
+        int closed = unzCloseCurrentFile(zfile);
+
+        uLong crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef *) expected.constData(), (uInt) expected.size());
+        if ((read < 0) || (closed != UNZ_OK) || (found != expected) ||
+            (file_info.crc != crc) || (file_info.uncompressed_size != (ZPOS64_T) expected.size())) {
+            fprintf(stderr, "%s: read %d close %d crc %08lx expected %08lx\n", qPrintable(name),
+                    read, closed, (unsigned long) file_info.crc, (unsigned long) crc);
+            ok = false;
+        }
+    }
+    unzClose(zfile);
+    return ok;
+}
+
+
+static QByteArray ReadAll(const QString &path)
+{
+    QFile file(path);
+    file.open(QIODevice::ReadOnly);
+    return file.readAll();
+}
+
+
+int main(int argc, char *argv[])
+{
+    QTemporaryDir tempdir;
+    if (!tempdir.isValid()) {
+        fprintf(stderr, "cannot create a temporary folder\n");
+        return 1;
+    }
+    QString folder = tempdir.path();
+
+    QList<qint64> sizes;
+    sizes << 0 << 1 << 1000 << CHUNK - 1 << CHUNK << CHUNK + 1 << 2 * CHUNK << 5 * CHUNK + 12345;
+    // enough single chunk files to need more than one window of chunks
+    for (int i = 0; i < 300; i++) {
+        sizes << 4000 + i;
+    }
+
+    QStringList names;
+    for (int i = 0; i < sizes.count(); i++) {
+        QString name = QString("OEBPS/Text/file%1-%2.xhtml").arg(i).arg(sizes.at(i));
+        QDir(folder).mkpath("OEBPS/Text");
+        QFile file(folder + "/" + name);
+        if (!file.open(QIODevice::WriteOnly) || (file.write(TestData(sizes.at(i), i + 1)) != sizes.at(i))) {
+            fprintf(stderr, "cannot write %s\n", qPrintable(name));
+            return 1;
+        }
+        file.close();
+        names << name;
+    }
+
+    QString zippath = (argc > 1) ? QString::fromLocal8Bit(argv[1]) : folder + "/test.epub";
+    QString onethread = folder + "/onethread.epub";
+
+    if (!WriteArchive(zippath, folder, names) || !CheckArchive(zippath, folder, names)) {
+        return 1;
+    }
+
+    // the chunks do not depend on the number of threads used
+    QThreadPool::globalInstance()->setMaxThreadCount(1);
+    if (!WriteArchive(onethread, folder, names) || (ReadAll(onethread) != ReadAll(zippath))) {
+        fprintf(stderr, "archive differs when written with one thread\n");
+        return 1;
+    }
+
+    printf("%lld files stored and checked\n", (long long) names.count());
+    return 0;
+}